@@ -0,0 +1,110 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <exception>
+
+#include "../vrp-lib/vrp_solver.hpp"
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        if (argc < 6)
+        {
+            std::cerr << "Usage: " << argv[0] << " <local|global> <vehicle capacity> <max cities per route> <threads> <input file>... [--repeat N] [--fleet <file>] [--max-vehicles N]" << std::endl;
+            return 1;
+        }
+
+        std::string engineName = argv[1];
+        if (engineName != "local" && engineName != "global")
+        {
+            throw std::runtime_error("Unknown engine " + engineName + ".");
+        }
+        vrp::Engine engine = engineName == "global" ? vrp::Engine::Global : vrp::Engine::Local;
+        int vehicleCapacity = std::stoi(argv[2]);
+        int maxCitiesPerRoute = std::stoi(argv[3]);
+        unsigned threads = std::stoi(argv[4]);
+
+        std::vector<std::string> files;
+        int repeat = 1;
+        std::vector<vrp::VehicleType> fleet;
+        int maxVehicles = 0;
+        for (int i = 5; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg == "--repeat" && i + 1 < argc)
+            {
+                repeat = std::stoi(argv[++i]);
+            }
+            else if (arg == "--fleet" && i + 1 < argc)
+            {
+                fleet = vrp::readFleet(argv[++i]);
+            }
+            else if (arg == "--max-vehicles" && i + 1 < argc)
+            {
+                maxVehicles = std::stoi(argv[++i]);
+            }
+            else
+            {
+                files.push_back(arg);
+            }
+        }
+
+        std::vector<vrp::Instance> instances;
+        for (int r = 0; r < repeat; ++r)
+        {
+            for (const auto &file : files)
+            {
+                instances.push_back(vrp::readInstance(file, vehicleCapacity, maxCitiesPerRoute));
+                instances.back().fleet = fleet;
+                instances.back().maxVehicles = maxVehicles;
+            }
+        }
+
+        vrp::BatchSolver batch(threads);
+        auto startTime = std::chrono::high_resolution_clock::now();
+        std::vector<vrp::Solution> solutions = batch.solve(instances, engine);
+        auto endTime = std::chrono::high_resolution_clock::now();
+
+        for (size_t i = 0; i < files.size(); ++i)
+        {
+            const vrp::Solution &solution = solutions[i];
+            std::cout << files[i] << '\n';
+            std::cout << "Lower cost: " << (solution.feasible ? solution.cost : -1) << '\n';
+            int routesLength = solution.routes.size();
+            for (const auto &route : solution.routes)
+            {
+                for (int city : route)
+                {
+                    std::cout << city << " ";
+                }
+                if (--routesLength > 0)
+                {
+                    std::cout << "-> ";
+                }
+            }
+            std::cout << '\n';
+            if (!fleet.empty() || maxVehicles > 0)
+            {
+                std::cout << "Vehicle types:";
+                for (int type : solution.vehicleTypes)
+                {
+                    std::cout << ' ' << type;
+                }
+                std::cout << '\n';
+            }
+            std::cout << "Load: " << solution.loadMicros << " us, solve: " << solution.solveMicros << " us, nodes: " << solution.nodesExpanded << '\n';
+        }
+
+        double seconds = std::chrono::duration<double>(endTime - startTime).count();
+        std::cout << "Solved " << instances.size() << " instances on " << batch.threads() << " threads in " << seconds * 1000 << " milliseconds ("
+                  << instances.size() / seconds << " instances/s)" << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
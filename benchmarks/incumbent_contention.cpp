@@ -0,0 +1,115 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <omp.h>
+
+#include "../vrp-lib/incumbent.hpp"
+
+// Compares the two ways global-search-omp can share its best route: an omp critical section
+// around every comparison, and vrp::Incumbent. Every candidate is a short synthetic route
+// whose cost is a sum of pseudo-random legs, which is about the work of calculateRouteCost().
+
+using Route = std::vector<int>;
+
+constexpr int ROUTE_LENGTH = 12;
+
+static int legCost(uint64_t candidate, int leg)
+{
+    uint64_t x = candidate * 0x9E3779B97F4A7C15ULL + leg;
+    x ^= x >> 31;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 29;
+    return static_cast<int>(x % 1000);
+}
+
+static int candidateCost(uint64_t candidate, int bound)
+{
+    int cost = 0;
+    for (int leg = 0; leg < ROUTE_LENGTH && cost < bound; ++leg)
+    {
+        cost += legCost(candidate, leg);
+    }
+    return cost;
+}
+
+static Route candidateRoute(uint64_t candidate)
+{
+    Route route(ROUTE_LENGTH + 1, 0);
+    for (int leg = 1; leg < ROUTE_LENGTH; ++leg)
+    {
+        route[leg] = static_cast<int>((candidate + leg) % 64) + 1;
+    }
+    return route;
+}
+
+static double runCritical(long long candidates, int &bestCost)
+{
+    int lowerCost = INT_MAX;
+    Route bestRoute;
+    auto start = std::chrono::steady_clock::now();
+#pragma omp parallel for schedule(dynamic, 256)
+    for (long long i = 0; i < candidates; ++i)
+    {
+        int cost = candidateCost(i, INT_MAX);
+#pragma omp critical
+        {
+            if (cost < lowerCost)
+            {
+                lowerCost = cost;
+                bestRoute = candidateRoute(i);
+            }
+        }
+    }
+    bestCost = lowerCost;
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static double runLockFree(long long candidates, int &bestCost)
+{
+    vrp::Incumbent incumbent(omp_get_max_threads());
+    auto start = std::chrono::steady_clock::now();
+#pragma omp parallel
+    {
+        int thread = omp_get_thread_num();
+#pragma omp for schedule(dynamic, 256)
+        for (long long i = 0; i < candidates; ++i)
+        {
+            int bound = incumbent.bound();
+            int cost = candidateCost(i, bound);
+            if (cost < bound)
+            {
+                incumbent.offer(thread, cost, candidateRoute(i));
+            }
+        }
+    }
+    bestCost = incumbent.cost();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    long long candidates = argc > 1 ? std::stoll(argv[1]) : 4000000;
+    int maxThreads = argc > 2 ? std::stoi(argv[2]) : 64;
+
+    std::cout << "Candidates: " << candidates << std::endl;
+    std::cout << std::setw(8) << "threads" << std::setw(16) << "critical ms" << std::setw(16) << "lock-free ms" << std::setw(10) << "speedup" << std::endl;
+    for (int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        omp_set_num_threads(threads);
+        int criticalCost, lockFreeCost;
+        double critical = runCritical(candidates, criticalCost);
+        double lockFree = runLockFree(candidates, lockFreeCost);
+        if (criticalCost != lockFreeCost)
+        {
+            std::cerr << "Error: the two incumbents disagree (" << criticalCost << " vs " << lockFreeCost << ")." << std::endl;
+            return 1;
+        }
+        std::cout << std::setw(8) << threads << std::fixed << std::setprecision(1) << std::setw(16) << critical << std::setw(16) << lockFree
+                  << std::setw(10) << std::setprecision(2) << critical / lockFree << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <algorithm>
+#include <omp.h>
+
+#include "../vrp-lib/parallel_two_opt.hpp"
+
+// Times one 2-opt neighbourhood scan (the work of every step of twoOptBestImprovement()) on
+// random Euclidean routes of growing length, once on one thread and once by every OpenMP
+// thread with a min-reduction over their best moves. Both must pick the same move. The
+// crossover length is where vrp::PARALLEL_TWO_OPT_MIN_LENGTH belongs on this machine.
+
+using Route = std::vector<int>;
+
+struct Instance
+{
+    std::vector<double> xs;
+    std::vector<double> ys;
+
+    long long cost(int a, int b) const
+    {
+        return std::llround(std::hypot(xs[a] - xs[b], ys[a] - ys[b]));
+    }
+};
+
+static Instance randomInstance(int cities, unsigned seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<double> coordinate(0, 10000);
+    Instance instance;
+    for (int city = 0; city < cities; ++city)
+    {
+        instance.xs.push_back(coordinate(random));
+        instance.ys.push_back(coordinate(random));
+    }
+    return instance;
+}
+
+// Milliseconds per scan, averaged over enough repetitions to cover about 4 million moves.
+static double scan(const Instance &instance, const Route &route, bool parallel, vrp::TwoOptMove &move)
+{
+    auto cost = [&instance](int a, int b)
+    {
+        return instance.cost(a, b);
+    };
+    long long moves = static_cast<long long>(route.size()) * route.size() / 2;
+    int repetitions = static_cast<int>(std::max<long long>(1, 4000000 / moves));
+    auto start = std::chrono::steady_clock::now();
+    for (int repetition = 0; repetition < repetitions; ++repetition)
+    {
+        move = vrp::bestTwoOptMove(route, cost, parallel);
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repetitions;
+}
+
+int main(int argc, char *argv[])
+{
+    int maxLength = argc > 1 ? std::stoi(argv[1]) : 8192;
+
+    std::cout << "threads: " << omp_get_max_threads() << std::endl;
+    std::cout << std::setw(8) << "length" << std::setw(14) << "serial ms" << std::setw(14) << "parallel ms" << std::setw(10) << "speedup" << std::endl;
+    for (int length = 16; length <= maxLength; length *= 2)
+    {
+        Instance instance = randomInstance(length, 7);
+        Route route{0};
+        for (int city = 1; city < length; ++city)
+        {
+            route.push_back(city);
+        }
+        route.push_back(0);
+
+        vrp::TwoOptMove serial;
+        vrp::TwoOptMove parallel;
+        double serialMillis = scan(instance, route, false, serial);
+        double parallelMillis = scan(instance, route, true, parallel);
+        if (serial.delta != parallel.delta || serial.i != parallel.i || serial.j != parallel.j)
+        {
+            std::cerr << "Serial and parallel scans picked different moves at length " << length << std::endl;
+            return 1;
+        }
+        std::cout << std::setw(8) << length << std::fixed << std::setprecision(3) << std::setw(14) << serialMillis
+                  << std::setw(14) << parallelMillis << std::setprecision(2) << std::setw(10) << serialMillis / parallelMillis << std::endl;
+    }
+    return 0;
+}
@@ -11,9 +11,21 @@
 #include <omp.h>
 #include <mpi.h>
 #include <climits>
+#include <cstdio>
+#include <csignal>
+#include <memory>
+
+#include "../vrp-lib/checkpoint.hpp"
+#include "../vrp-lib/packed_route.hpp"
+#include "../vrp-lib/result_writer.hpp"
+#include "../vrp-lib/route_hash_set.hpp"
+#include "../vrp-lib/shortest_paths.hpp"
+#include "../vrp-lib/telemetry.hpp"
 
 using Route = std::vector<int>;
 
+volatile std::sig_atomic_t stopRequested = 0;
+
 struct City
 {
     int number;
@@ -39,8 +51,17 @@ class VRPSolver
 private:
     std::vector<City> cities;
     std::vector<Road> roads;
-    std::vector<Route> routes;
+    vrp::PackedRoutes routes; // complete routes, one fixed-size record each
+    std::vector<int> roadCosts; // numberOfCities x numberOfCities, INT_MAX where there is no road
+    vrp::ShortestPaths shortestPaths;
+    bool shortestPathsEnabled = false;
     std::vector<std::tuple<std::set<int>, int, int, int, std::vector<int>>> stack;
+    std::vector<Route> inFlight; // route each thread is expanding, part of the checkpointed frontier
+    long long nodesExpanded = 0;
+    bool interrupted = false;
+    std::chrono::steady_clock::time_point lastCheckpoint;
+    std::chrono::steady_clock::duration lastCheckpointDuration{};
+    std::chrono::steady_clock::time_point solveStart;
 
 public:
     int lowerCost = INT_MAX;
@@ -50,10 +71,23 @@ public:
     int numberOfRoads;
     int numberOfCities;
     Route bestRoute;
+    bool deterministic = false;
+    std::string checkpointFile; // this rank's shard
+    int checkpointIntervalSeconds = 60;
+    bool resumeFromCheckpoint = false;
+    int checkpointsWritten = 0;
+    long long resumedMillis = 0; // search time recorded in the checkpoint this run resumed from
+    long long checkpointMillis = 0;
+    std::string telemetryTarget; // file or unix:<socket path>, empty for no reporter
+    int telemetryIntervalMillis = 1000;
+    int rank = 0;
+    std::unique_ptr<vrp::Telemetry> telemetry;
     VRPSolver(const std::string &filename)
     {
         readInput(filename);
         cities.insert(cities.begin(), {0, 0}); // Insert a dummy city representing the depot
+        buildRoadCosts();
+        routes = vrp::PackedRoutes(numberOfCities);
     }
 
     void getUserInput()
@@ -102,13 +136,107 @@ public:
         file.close();
     }
 
+    void buildRoadCosts()
+    {
+        roadCosts.assign(static_cast<size_t>(numberOfCities) * numberOfCities, INT_MAX);
+        for (const auto &road : roads)
+        {
+            int &cost = roadCosts[static_cast<size_t>(road.start.number) * numberOfCities + road.destination.number];
+            if (cost == INT_MAX)
+            {
+                cost = road.cost;
+            }
+        }
+    }
+
+    // Replaces direct roads by shortest paths, so a trip may pass through other cities on its way.
+    void useShortestPaths()
+    {
+        std::vector<vrp::Edge> edges;
+        edges.reserve(roads.size());
+        for (const auto &road : roads)
+        {
+            edges.push_back({road.start.number, road.destination.number, road.cost});
+        }
+        shortestPaths.compute(numberOfCities, edges);
+        roadCosts = shortestPaths.matrix();
+        shortestPathsEnabled = true;
+    }
+
+    bool usedFloydWarshall() const
+    {
+        return shortestPaths.usedFloydWarshall();
+    }
+
+    size_t routesEnumerated() const
+    {
+        return routes.size();
+    }
+
+    // The route with every leg expanded into the roads it actually drives on.
+    Route expandedRoute(const Route &route) const
+    {
+        return shortestPathsEnabled ? shortestPaths.expand(route) : route;
+    }
+
+    // Every customer is entered once, and every trip ends with a road into the depot.
+    long long lowerBound() const
+    {
+        long long bound = 0;
+        long long totalWeight = 0;
+        int cheapestReturn = INT_MAX;
+        for (int city = 1; city < numberOfCities; ++city)
+        {
+            int cheapestEntry = INT_MAX;
+            for (int from = 0; from < numberOfCities; ++from)
+            {
+                if (from != city)
+                {
+                    cheapestEntry = std::min(cheapestEntry, roadCosts[static_cast<size_t>(from) * numberOfCities + city]);
+                }
+            }
+            bound += cheapestEntry == INT_MAX ? 0 : cheapestEntry;
+            cheapestReturn = std::min(cheapestReturn, roadCosts[static_cast<size_t>(city) * numberOfCities]);
+        }
+        // cities[] is shifted by the depot entry, so weights are read by city number like the search does.
+        for (const City &city : cities)
+        {
+            if (city.number != 0)
+            {
+                totalWeight += city.package_weight;
+            }
+        }
+        if (cheapestReturn == INT_MAX || vehicleCapacity <= 0 || maxCitiesPerRoute <= 0)
+        {
+            return bound;
+        }
+        long long trips = std::max((totalWeight + vehicleCapacity - 1) / vehicleCapacity,
+                                   static_cast<long long>(numberOfCities - 1 + maxCitiesPerRoute - 1) / maxCitiesPerRoute);
+        return bound + trips * cheapestReturn;
+    }
+
     void solve()
     {
-        std::set<int> citiesVisited;
-        citiesVisited.insert(0);
-        std::vector<int> route{0};
-        stack.emplace_back(citiesVisited, 0, 0, 0, route);
+        telemetry = std::make_unique<vrp::Telemetry>(omp_get_max_threads());
+        telemetry->setLowerBound(lowerBound());
+        if (!telemetryTarget.empty())
+        {
+            // Every rank reports on its own; a file is sharded like the checkpoints.
+            telemetry->start(telemetryTarget.rfind("unix:", 0) == 0 ? telemetryTarget : telemetryTarget + ".rank" + std::to_string(rank),
+                             telemetryIntervalMillis, rank);
+        }
+        solveStart = std::chrono::steady_clock::now();
+        if (!resumeFromCheckpoint || !restoreCheckpoint())
+        {
+            std::set<int> citiesVisited;
+            citiesVisited.insert(0);
+            std::vector<int> route{0};
+            stack.emplace_back(citiesVisited, 0, 0, 0, route);
+        }
+        inFlight.assign(omp_get_max_threads(), Route());
+        lastCheckpoint = std::chrono::steady_clock::now();
 
+        telemetry->setPhase("enumerate");
 #pragma omp parallel
         {
 #pragma omp single nowait
@@ -117,33 +245,68 @@ public:
             }
         }
 
-        std::set<Route> filteredRoutes = filterValidRoutes();
+        if (interrupted)
+        {
+            throw std::runtime_error("Interrupted, search state saved to " + checkpointFile + ".");
+        }
+        if (!checkpointFile.empty())
+        {
+            std::remove(checkpointFile.c_str());
+        }
+
+        telemetry->setPhase("filter");
+        vrp::PackedRoutes candidates = vrp::uniqueValidRoutes(routes, numberOfCities, roadCosts, telemetry.get());
 
-#pragma omp parallel for schedule(dynamic)
-        for (int i = 0; i < filteredRoutes.size(); ++i)
+        telemetry->setPhase("evaluate");
+#pragma omp parallel
         {
-            auto route = std::next(filteredRoutes.begin(), i);
-            int cost = calculateRouteCost(*route);
+            vrp::ThreadTelemetry &counters = telemetry->thread(omp_get_thread_num());
+            counters.setBusy(true);
+            Route route;
+#pragma omp for schedule(dynamic)
+            for (size_t i = 0; i < candidates.size(); ++i)
+            {
+                candidates.decode(i, route);
+                int cost = calculateRouteCost(route);
+                counters.addRoutes(1);
 
 #pragma omp critical
-            {
-                if (cost < lowerCost)
                 {
-                    lowerCost = cost;
-                    bestRoute = *route;
+                    // Equal costs go to the lexicographically smallest route, so the result does not
+                    // depend on the order threads get here.
+                    if (cost < lowerCost || (deterministic && cost == lowerCost && route < bestRoute))
+                    {
+                        lowerCost = cost;
+                        bestRoute = route;
+                        telemetry->offerIncumbent(cost);
+                    }
                 }
             }
+            counters.setBusy(false);
         }
+        telemetry->setPhase("done");
+        telemetry->stop();
     }
 
     void generateAllPossibleRoutesLoop()
     {
+        bool checkpointing = !checkpointFile.empty();
+        int thread = omp_get_thread_num();
+        vrp::ThreadTelemetry &counters = telemetry->thread(thread);
+        counters.setBusy(true);
+        std::vector<std::tuple<std::set<int>, int, int, int, std::vector<int>>> children;
+        vrp::PackedRoutes completed(numberOfCities);
+
         while (true)
         {
             std::tuple<std::set<int>, int, int, int, std::vector<int>> current;
 #pragma omp critical
             {
-                if (stack.empty())
+                if (checkpointing && ((++nodesExpanded & 1023) == 0 || stopRequested))
+                {
+                    maybeCheckpoint();
+                }
+                if (stack.empty() || interrupted)
                 {
                     current = std::tuple<std::set<int>, int, int, int, std::vector<int>>();
                 }
@@ -151,6 +314,11 @@ public:
                 {
                     current = stack.back();
                     stack.pop_back();
+                    telemetry->setFrontier(stack.size());
+                    if (checkpointing)
+                    {
+                        inFlight[thread] = std::get<4>(current);
+                    }
                 }
             }
 
@@ -158,6 +326,7 @@ public:
             {
                 break;
             }
+            counters.addNodes(1);
 
             auto [placesVisited, numberOfPlacesVisited, previousCity, vehicleLoad, route] = current;
 
@@ -194,56 +363,113 @@ public:
                 {
                     if (newPlacesVisited.size() == numberOfCities)
                     {
-#pragma omp critical
-                        routes.push_back(newRoute);
+                        completed.push_back(newRoute);
                     }
-#pragma omp critical
-                    stack.emplace_back(newPlacesVisited, 0, currentCity, 0, newRoute);
+                    children.emplace_back(newPlacesVisited, 0, currentCity, 0, newRoute);
                 }
                 else
                 {
+                    children.emplace_back(newPlacesVisited, numberOfPlacesVisited + 1, currentCity, vehicleLoad + city.package_weight, newRoute);
+                }
+            }
+
+            // Children are published together with clearing the in-flight slot, so a checkpoint
+            // never sees an entry both expanded and pending.
 #pragma omp critical
-                    stack.emplace_back(newPlacesVisited, numberOfPlacesVisited + 1, currentCity, vehicleLoad + city.package_weight, newRoute);
+            {
+                routes.append(completed);
+                stack.insert(stack.end(), std::make_move_iterator(children.begin()), std::make_move_iterator(children.end()));
+                if (checkpointing)
+                {
+                    inFlight[thread].clear();
                 }
             }
+            completed.clear();
+            children.clear();
         }
+        counters.setBusy(false);
     }
 
-    std::set<Route> filterValidRoutes()
+    // Called inside the critical section that guards stack, routes and inFlight.
+    void maybeCheckpoint()
     {
-        std::set<Route> validRoutes;
+        // Keep at least 100x the last write between checkpoints so they stay under 1% of the run.
+        auto now = std::chrono::steady_clock::now();
+        auto interval = std::max<std::chrono::steady_clock::duration>(std::chrono::seconds(checkpointIntervalSeconds), 100 * lastCheckpointDuration);
+        if (interrupted || (!stopRequested && now - lastCheckpoint < interval))
+        {
+            return;
+        }
 
-#pragma omp parallel
+        vrp::Checkpoint state;
+        state.numberOfCities = numberOfCities;
+        state.vehicleCapacity = vehicleCapacity;
+        state.maxCitiesPerRoute = maxCitiesPerRoute;
+        state.lowerCost = lowerCost;
+        state.bestRoute = bestRoute;
+        state.nodesExpanded = nodesExpanded;
+        state.elapsedMillis = resumedMillis + std::chrono::duration_cast<std::chrono::milliseconds>(now - solveStart).count();
+        for (const auto &entry : stack)
         {
-            std::set<Route> threadValidRoutes;
-#pragma omp for schedule(dynamic)
-            for (size_t i = 0; i < routes.size(); ++i)
+            state.frontier.push_back(std::get<4>(entry));
+        }
+        for (const auto &route : inFlight)
+        {
+            if (!route.empty())
             {
-                const Route &route = routes[i];
-                bool routeIsValid = true;
-                for (size_t j = 0; j < route.size() - 1; ++j)
-                {
-                    int source = route[j];
-                    int destination = route[j + 1];
-                    bool found = std::any_of(roads.begin(), roads.end(), [source, destination](const Road &road)
-                                             { return road.start.number == source && road.destination.number == destination; });
-
-                    if (!found)
-                    {
-                        routeIsValid = false;
-                        break;
-                    }
-                }
-                if (routeIsValid)
-                {
-                    threadValidRoutes.insert(route);
-                }
+                state.frontier.push_back(route);
             }
-#pragma omp critical
-            validRoutes.insert(threadValidRoutes.begin(), threadValidRoutes.end());
+        }
+        state.routes = routes.unpack();
+        vrp::writeCheckpoint(checkpointFile, state);
+
+        lastCheckpoint = std::chrono::steady_clock::now();
+        lastCheckpointDuration = lastCheckpoint - now;
+        checkpointMillis += std::chrono::duration_cast<std::chrono::milliseconds>(lastCheckpointDuration).count();
+        checkpointsWritten++;
+        interrupted = stopRequested;
+    }
+
+    bool restoreCheckpoint()
+    {
+        vrp::Checkpoint state;
+        if (!vrp::readCheckpoint(checkpointFile, state))
+        {
+            return false;
+        }
+        if (state.numberOfCities != numberOfCities || state.vehicleCapacity != vehicleCapacity || state.maxCitiesPerRoute != maxCitiesPerRoute)
+        {
+            throw std::runtime_error("Checkpoint " + checkpointFile + " was written for a different instance.");
         }
 
-        return validRoutes;
+        std::map<int, int> packageWeights;
+        for (const auto &city : cities)
+        {
+            packageWeights[city.number] = city.package_weight;
+        }
+
+        // The visited set, stop count and load of a stack entry all follow from its route.
+        for (const auto &route : state.frontier)
+        {
+            std::set<int> placesVisited(route.begin(), route.end());
+            int numberOfPlacesVisited = 0;
+            int vehicleLoad = 0;
+            for (auto city = route.rbegin(); city != route.rend() && *city != 0; ++city)
+            {
+                numberOfPlacesVisited++;
+                vehicleLoad += packageWeights[*city];
+            }
+            stack.emplace_back(placesVisited, numberOfPlacesVisited, route.back(), vehicleLoad, route);
+        }
+        for (const auto &route : state.routes)
+        {
+            routes.push_back(route);
+        }
+        lowerCost = state.lowerCost;
+        bestRoute = state.bestRoute;
+        nodesExpanded = state.nodesExpanded;
+        resumedMillis = state.elapsedMillis;
+        return true;
     }
 
     int calculateRouteCost(Route route)
@@ -254,14 +480,7 @@ public:
             int source = route[i];
             int destination = route[i + 1];
 
-            for (const auto &road : roads)
-            {
-                if (road.start.number == source && road.destination.number == destination)
-                {
-                    cost += road.cost;
-                    break;
-                }
-            }
+            cost += roadCosts[static_cast<size_t>(source) * numberOfCities + destination];
         }
 
         return cost;
@@ -280,16 +499,75 @@ int main(int argc, char *argv[])
     {
         if (argc < 2)
         {
-            std::cerr << "Usage: " << argv[0] << " <input file>" << std::endl;
+            std::cerr << "Usage: " << argv[0] << " <input file> [vehicle capacity] [max cities per route] [--shortest-paths] [--output text|json|csv] [--deterministic] [--checkpoint <file> [--checkpoint-interval <seconds>] [--resume]] [--telemetry <file|unix:path> [--telemetry-interval <ms>]]" << std::endl;
             MPI_Finalize();
             return 1;
         }
 
+        auto loadStart = std::chrono::high_resolution_clock::now();
         VRPSolver solver(argv[1]);
-        if (argc > 2)
+        solver.rank = rank;
+        double loadMillis = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - loadStart).count();
+        vrp::OutputFormat output = vrp::OutputFormat::Text;
+
+        std::vector<std::string> positional;
+        bool shortestPaths = false;
+        for (int i = 2; i < argc; ++i)
         {
-            solver.vehicleCapacity = std::stoi(argv[2]);
-            solver.maxCitiesPerRoute = std::stoi(argv[3]);
+            std::string arg = argv[i];
+            if (arg == "--shortest-paths")
+            {
+                shortestPaths = true;
+            }
+            else if (arg == "--output" && i + 1 < argc)
+            {
+                output = vrp::parseOutputFormat(argv[++i]);
+            }
+            else if (arg == "--deterministic")
+            {
+                solver.deterministic = true;
+            }
+            else if (arg == "--checkpoint" && i + 1 < argc)
+            {
+                solver.checkpointFile = std::string(argv[++i]) + ".rank" + std::to_string(rank);
+            }
+            else if (arg == "--checkpoint-interval" && i + 1 < argc)
+            {
+                solver.checkpointIntervalSeconds = std::stoi(argv[++i]);
+            }
+            else if (arg == "--resume")
+            {
+                solver.resumeFromCheckpoint = true;
+            }
+            else if (arg == "--telemetry" && i + 1 < argc)
+            {
+                solver.telemetryTarget = argv[++i];
+            }
+            else if (arg == "--telemetry-interval" && i + 1 < argc)
+            {
+                solver.telemetryIntervalMillis = std::stoi(argv[++i]);
+            }
+            else
+            {
+                positional.push_back(arg);
+            }
+        }
+        if (solver.resumeFromCheckpoint && solver.checkpointFile.empty())
+        {
+            throw std::runtime_error("--resume requires --checkpoint <file>.");
+        }
+        if (!solver.checkpointFile.empty())
+        {
+            std::signal(SIGTERM, [](int)
+                        { stopRequested = 1; });
+            std::signal(SIGINT, [](int)
+                        { stopRequested = 1; });
+        }
+
+        if (positional.size() >= 2)
+        {
+            solver.vehicleCapacity = std::stoi(positional[0]);
+            solver.maxCitiesPerRoute = std::stoi(positional[1]);
         }
         else
         {
@@ -301,6 +579,19 @@ int main(int argc, char *argv[])
             MPI_Bcast(&solver.maxCitiesPerRoute, 1, MPI_INT, 0, MPI_COMM_WORLD);
         }
 
+        double pathsMillis = 0;
+        if (shortestPaths)
+        {
+            auto pathsStart = std::chrono::high_resolution_clock::now();
+            solver.useShortestPaths();
+            auto pathsTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - pathsStart);
+            pathsMillis = pathsTime.count() / 1000.0;
+            if (rank == 0 && output == vrp::OutputFormat::Text)
+            {
+                std::cout << "Shortest paths (" << (solver.usedFloydWarshall() ? "Floyd-Warshall" : "Dijkstra") << "): " << pathsTime.count() << " microseconds" << std::endl;
+            }
+        }
+
         auto startTime = std::chrono::high_resolution_clock::now();
         solver.solve();
         auto endTime = std::chrono::high_resolution_clock::now();
@@ -308,14 +599,37 @@ int main(int argc, char *argv[])
         int globalLowerCost;
         MPI_Reduce(&solver.lowerCost, &globalLowerCost, 1, MPI_INT, MPI_MIN, 0, MPI_COMM_WORLD);
 
-        if (rank == 0)
+        std::vector<int> allLowerCosts(size);
+        MPI_Gather(&solver.lowerCost, 1, MPI_INT, allLowerCosts.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+        if (rank == 0 && output != vrp::OutputFormat::Text)
+        {
+            vrp::RunResult result;
+            result.engine = "global-search-mpi";
+            result.instance = argv[1];
+            result.cities = solver.numberOfCities - 1;
+            result.roads = solver.numberOfRoads;
+            result.vehicleCapacity = solver.vehicleCapacity;
+            result.maxCitiesPerRoute = solver.maxCitiesPerRoute;
+            result.cost = globalLowerCost;
+            result.routes = vrp::splitTrips(solver.expandedRoute(solver.bestRoute));
+            result.threads = omp_get_max_threads();
+            result.ranks = size;
+            result.rankCosts.assign(allLowerCosts.begin(), allLowerCosts.end());
+            result.timingsMillis = {{"load", loadMillis}, {"shortestPaths", pathsMillis}, {"solve", std::chrono::duration<double, std::milli>(endTime - startTime).count() + solver.resumedMillis}};
+            result.counters = {{"routesEnumerated", static_cast<long long>(solver.routesEnumerated())}, {"checkpointsWritten", solver.checkpointsWritten},
+                               {"nodesExpanded", solver.telemetry->nodes()}, {"routesPriced", solver.telemetry->routes()}};
+            vrp::writeResult(result, output);
+        }
+        else if (rank == 0)
         {
             std::cout << "Results for " << solver.numberOfCities - 1 << " cities and " << solver.numberOfRoads << " routes..." << std::endl;
             std::cout << "Lower cost: " << globalLowerCost << std::endl;
 
-            int lastCityIndex = solver.bestRoute.size() - 1;
+            Route bestRoute = solver.expandedRoute(solver.bestRoute);
+            int lastCityIndex = bestRoute.size() - 1;
             int counter = 0;
-            for (const auto &city : solver.bestRoute)
+            for (const auto &city : bestRoute)
             {
                 std::cout << city;
                 if (counter < lastCityIndex)
@@ -325,8 +639,13 @@ int main(int argc, char *argv[])
                 counter++;
             }
             std::cout << std::endl;
-            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
+            // A resumed search counts the time recorded before it was interrupted as well.
+            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime) + std::chrono::milliseconds(solver.resumedMillis);
             std::cout << "Time taken: " << duration.count() << " milliseconds" << std::endl;
+            if (!solver.checkpointFile.empty())
+            {
+                std::cout << "Checkpoints: " << solver.checkpointsWritten << " written in " << solver.checkpointMillis << " milliseconds" << std::endl;
+            }
         }
     }
     catch (const std::exception &e)
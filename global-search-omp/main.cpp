@@ -10,6 +10,16 @@
 #include <tuple>
 #include <omp.h>
 #include <climits>
+#include <memory>
+
+#include "../vrp-lib/incumbent.hpp"
+#include "../vrp-lib/numa.hpp"
+#include "../vrp-lib/packed_route.hpp"
+#include "../vrp-lib/result_writer.hpp"
+#include "../vrp-lib/route_hash_set.hpp"
+#include "../vrp-lib/shortest_paths.hpp"
+#include "../vrp-lib/telemetry.hpp"
+#include "../vrp-lib/trip_cache.hpp"
 
 using Route = std::vector<int>;
 
@@ -38,8 +48,14 @@ class VRPSolver
 private:
     std::vector<City> cities;
     std::vector<Road> roads;
-    std::vector<Route> routes;
+    vrp::PackedRoutes routes; // complete routes, one fixed-size record each
+    std::vector<int> roadCosts; // numberOfCities x numberOfCities, INT_MAX where there is no road
+    vrp::ShortestPaths shortestPaths;
+    bool shortestPathsEnabled = false;
     std::vector<std::tuple<std::set<int>, int, int, int, std::vector<int>>> stack;
+    vrp::NumaTopology topology;
+    vrp::NodeReplicas<int> costReplicas;
+    std::vector<int> threadNode;
 
 public:
     int lowerCost = INT_MAX;
@@ -49,10 +65,20 @@ public:
     int numberOfRoads;
     int numberOfCities;
     Route bestRoute;
+    bool deterministic = false;
+    bool numaAware = false;
+    std::vector<int> affinity; // cpu of every thread, empty for the default spread
+    size_t tripCacheBytes = vrp::TripCache::DEFAULT_BYTES; // 0 disables the cache
+    std::unique_ptr<vrp::TripCache> tripCache;
+    std::string telemetryTarget; // file or unix:<socket path>, empty for no reporter
+    int telemetryIntervalMillis = 1000;
+    std::unique_ptr<vrp::Telemetry> telemetry;
     VRPSolver(const std::string &filename)
     {
         readInput(filename);
         cities.insert(cities.begin(), {0, 0}); // Insert a dummy city representing the depot
+        buildRoadCosts();
+        routes = vrp::PackedRoutes(numberOfCities);
     }
 
     void getUserInput()
@@ -101,13 +127,137 @@ public:
         file.close();
     }
 
+    void buildRoadCosts()
+    {
+        roadCosts.assign(static_cast<size_t>(numberOfCities) * numberOfCities, INT_MAX);
+        for (const auto &road : roads)
+        {
+            int &cost = roadCosts[static_cast<size_t>(road.start.number) * numberOfCities + road.destination.number];
+            if (cost == INT_MAX)
+            {
+                cost = road.cost;
+            }
+        }
+    }
+
+    // Replaces direct roads by shortest paths, so a trip may pass through other cities on its way.
+    void useShortestPaths()
+    {
+        std::vector<vrp::Edge> edges;
+        edges.reserve(roads.size());
+        for (const auto &road : roads)
+        {
+            edges.push_back({road.start.number, road.destination.number, road.cost});
+        }
+        shortestPaths.compute(numberOfCities, edges);
+        roadCosts = shortestPaths.matrix();
+        shortestPathsEnabled = true;
+    }
+
+    bool usedFloydWarshall() const
+    {
+        return shortestPaths.usedFloydWarshall();
+    }
+
+    size_t routesEnumerated() const
+    {
+        return routes.size();
+    }
+
+    // The route with every leg expanded into the roads it actually drives on.
+    Route expandedRoute(const Route &route) const
+    {
+        return shortestPathsEnabled ? shortestPaths.expand(route) : route;
+    }
+
+    // Pins every OpenMP thread and has the first thread on each node copy the cost matrix into
+    // that node's replica, so route costing reads local memory.
+    void setUpNuma()
+    {
+        topology = vrp::NumaTopology::detect();
+        costReplicas.allocate(topology.nodes(), roadCosts.size());
+        threadNode.assign(omp_get_max_threads(), 0);
+        std::vector<char> filled(topology.nodes(), 0);
+
+#pragma omp parallel
+        {
+            int thread = omp_get_thread_num();
+            int cpu = topology.cpuForThread(thread, affinity);
+            if (!vrp::pinCurrentThread(cpu))
+            {
+#pragma omp critical
+                std::cerr << "Warning: could not pin thread " << thread << " to CPU " << cpu << "." << std::endl;
+            }
+            int node = topology.nodeOfCpu(cpu);
+            threadNode[thread] = node;
+            bool fill = false;
+#pragma omp critical
+            {
+                fill = !filled[node];
+                filled[node] = 1;
+            }
+            if (fill)
+            {
+                costReplicas.fill(node, roadCosts.data());
+            }
+        }
+    }
+
+    // Every customer is entered once, and every trip ends with a road into the depot.
+    long long lowerBound() const
+    {
+        long long bound = 0;
+        long long totalWeight = 0;
+        int cheapestReturn = INT_MAX;
+        for (int city = 1; city < numberOfCities; ++city)
+        {
+            int cheapestEntry = INT_MAX;
+            for (int from = 0; from < numberOfCities; ++from)
+            {
+                if (from != city)
+                {
+                    cheapestEntry = std::min(cheapestEntry, roadCosts[static_cast<size_t>(from) * numberOfCities + city]);
+                }
+            }
+            bound += cheapestEntry == INT_MAX ? 0 : cheapestEntry;
+            cheapestReturn = std::min(cheapestReturn, roadCosts[static_cast<size_t>(city) * numberOfCities]);
+        }
+        // cities[] is shifted by the depot entry, so weights are read by city number like the search does.
+        for (const City &city : cities)
+        {
+            if (city.number != 0)
+            {
+                totalWeight += city.package_weight;
+            }
+        }
+        if (cheapestReturn == INT_MAX || vehicleCapacity <= 0 || maxCitiesPerRoute <= 0)
+        {
+            return bound;
+        }
+        long long trips = std::max((totalWeight + vehicleCapacity - 1) / vehicleCapacity,
+                                   static_cast<long long>(numberOfCities - 1 + maxCitiesPerRoute - 1) / maxCitiesPerRoute);
+        return bound + trips * cheapestReturn;
+    }
+
     void solve()
     {
+        telemetry = std::make_unique<vrp::Telemetry>(omp_get_max_threads());
+        telemetry->setLowerBound(lowerBound());
+        if (!telemetryTarget.empty())
+        {
+            telemetry->start(telemetryTarget, telemetryIntervalMillis);
+        }
+        if (numaAware)
+        {
+            setUpNuma();
+        }
+
         std::set<int> citiesVisited;
         citiesVisited.insert(0);
         std::vector<int> route{0};
         stack.emplace_back(citiesVisited, 0, 0, 0, route);
 
+        telemetry->setPhase("enumerate");
 #pragma omp parallel
         {
 #pragma omp single nowait
@@ -116,27 +266,107 @@ public:
             }
         }
 
-        std::set<Route> filteredRoutes = filterValidRoutes();
+        telemetry->setPhase("filter");
+        vrp::PackedRoutes candidates = vrp::uniqueValidRoutes(routes, numberOfCities, roadCosts, telemetry.get());
+        vrp::Incumbent incumbent(omp_get_max_threads());
+        // Shared by all threads: a customer set is sequenced by whichever thread meets it first.
+        if (tripCacheBytes > 0)
+        {
+            tripCache = std::make_unique<vrp::TripCache>(numberOfCities, vrp::TripCache::customerSets(numberOfCities - 1, maxCitiesPerRoute), tripCacheBytes);
+        }
+        std::unique_ptr<vrp::NumaWorkQueues> queues;
+        if (numaAware)
+        {
+            queues = std::make_unique<vrp::NumaWorkQueues>(topology.nodes(), candidates.size(), 256);
+        }
 
-#pragma omp parallel for
-        for (int i = 0; i < filteredRoutes.size(); ++i)
+        // Threads prune against a relaxed read of the shared bound and publish improvements
+        // with a CAS, so there is no lock on the per-route path.
+        telemetry->setPhase("evaluate");
+#pragma omp parallel
         {
-            auto route = std::next(filteredRoutes.begin(), i);
-            int cost = calculateRouteCost(*route);
+            int thread = omp_get_thread_num();
+            vrp::ThreadTelemetry &counters = telemetry->thread(thread);
+            counters.setBusy(true);
+            int threadCost = INT_MAX;
+            Route threadRoute;
+            Route candidate;
+            auto evaluate = [&](size_t i, const int *costs)
+            {
+                // Deterministic runs keep ties, which go to the lexicographically smallest route.
+                candidates.decode(i, candidate);
+                int bound = incumbent.bound();
+                int limit = deterministic && bound != INT_MAX ? bound + 1 : bound;
+                int cost = tripCache ? calculateCachedRouteCost(candidate, limit, costs) : calculateRouteCost(candidate, limit, costs);
+                if (deterministic && cost <= bound)
+                {
+                    if (cost < threadCost || (cost == threadCost && candidate < threadRoute))
+                    {
+                        threadCost = cost;
+                        threadRoute = candidate;
+                    }
+                }
+                if (cost < bound && incumbent.offer(thread, cost, candidate))
+                {
+                    telemetry->offerIncumbent(cost);
+                }
+                counters.addRoutes(1);
+            };
 
-#pragma omp critical
+            if (numaAware)
             {
-                if (cost < lowerCost)
+                int node = threadNode[thread];
+                const int *costs = costReplicas.on(node);
+                size_t begin, end;
+                while (queues->next(node, begin, end))
                 {
-                    lowerCost = cost;
-                    bestRoute = *route;
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        evaluate(i, costs);
+                    }
+                }
+            }
+            else
+            {
+#pragma omp for schedule(dynamic, 256) nowait
+                for (size_t i = 0; i < candidates.size(); ++i)
+                {
+                    evaluate(i, roadCosts.data());
                 }
             }
+            counters.setBusy(false);
+
+            if (deterministic && threadCost != INT_MAX)
+            {
+#pragma omp critical
+                if (threadCost < lowerCost || (threadCost == lowerCost && threadRoute < bestRoute))
+                {
+                    lowerCost = threadCost;
+                    bestRoute = threadRoute;
+                }
+            }
+        }
+
+        if (!deterministic && incumbent.cost() < lowerCost)
+        {
+            lowerCost = incumbent.cost();
+            bestRoute = incumbent.route();
         }
+        // The winner was priced with its trips in their cached order, so print it that way.
+        if (tripCache && !bestRoute.empty())
+        {
+            Route ordered;
+            calculateCachedRouteCost(bestRoute, INT_MAX, roadCosts.data(), &ordered);
+            bestRoute = ordered;
+        }
+        telemetry->setPhase("done");
+        telemetry->stop();
     }
 
     void generateAllPossibleRoutesLoop()
     {
+        vrp::ThreadTelemetry &counters = telemetry->thread(omp_get_thread_num());
+        counters.setBusy(true);
         while (true)
         {
             std::tuple<std::set<int>, int, int, int, std::vector<int>> current;
@@ -150,6 +380,7 @@ public:
                 {
                     current = stack.back();
                     stack.pop_back();
+                    telemetry->setFrontier(stack.size());
                 }
             }
 
@@ -157,6 +388,7 @@ public:
             {
                 break;
             }
+            counters.addNodes(1);
 
             auto [placesVisited, numberOfPlacesVisited, previousCity, vehicleLoad, route] = current;
 
@@ -206,64 +438,77 @@ public:
                 }
             }
         }
+        counters.setBusy(false);
     }
 
-    std::set<Route> filterValidRoutes()
+    // Stops as soon as the partial cost reaches bound; the route can no longer win then.
+    int calculateRouteCost(const Route &route, int bound = INT_MAX, const int *costs = nullptr)
     {
-        std::set<Route> validRoutes;
-
-#pragma omp parallel
+        if (costs == nullptr)
         {
-            std::set<Route> threadValidRoutes;
-#pragma omp for nowait
-            for (size_t i = 0; i < routes.size(); ++i)
-            {
-                const Route &route = routes[i];
-                bool routeIsValid = true;
-                for (size_t j = 0; j < route.size() - 1; ++j)
-                {
-                    int source = route[j];
-                    int destination = route[j + 1];
-                    bool found = std::any_of(roads.begin(), roads.end(), [source, destination](const Road &road)
-                                             { return road.start.number == source && road.destination.number == destination; });
+            costs = roadCosts.data();
+        }
+        int cost = 0;
+        for (size_t i = 0; i < route.size() - 1 && cost < bound; ++i)
+        {
+            int source = route[i];
+            int destination = route[i + 1];
 
-                    if (!found)
-                    {
-                        routeIsValid = false;
-                        break;
-                    }
-                }
-                if (routeIsValid)
-                {
-                    threadValidRoutes.insert(route);
-                }
-            }
-#pragma omp critical
-            validRoutes.insert(threadValidRoutes.begin(), threadValidRoutes.end());
+            cost += costs[static_cast<size_t>(source) * numberOfCities + destination];
         }
 
-        return validRoutes;
+        return cost;
     }
 
-    int calculateRouteCost(Route route)
+    // Like calculateRouteCost(), with every trip priced at the cached optimal cost of its
+    // customers. Trips too long for the cache are walked as they are. When ordered is given,
+    // it receives the route with its trips in the cached order.
+    int calculateCachedRouteCost(const Route &route, int bound, const int *costs, Route *ordered = nullptr)
     {
-        int cost = 0;
-        for (size_t i = 0; i < route.size() - 1; ++i)
+        auto cost = [costs, this](int source, int destination)
         {
-            int source = route[i];
-            int destination = route[i + 1];
-
-            for (const auto &road : roads)
+            return costs[static_cast<size_t>(source) * numberOfCities + destination];
+        };
+        if (ordered != nullptr)
+        {
+            ordered->assign(1, 0);
+        }
+        int total = 0;
+        size_t start = 1;
+        for (size_t i = 1; i < route.size() && total < bound; ++i)
+        {
+            if (route[i] != 0)
+            {
+                continue;
+            }
+            int count = static_cast<int>(i - start);
+            if (tripCache->cacheable(count))
+            {
+                vrp::CachedTrip trip = tripCache->trip(&route[start], count, cost);
+                total += trip.cost;
+                if (ordered != nullptr)
+                {
+                    ordered->insert(ordered->end(), trip.order.begin(), trip.order.begin() + trip.length);
+                }
+            }
+            else
             {
-                if (road.start.number == source && road.destination.number == destination)
+                for (size_t k = start - 1; k < i; ++k)
                 {
-                    cost += road.cost;
-                    break;
+                    total += cost(route[k], route[k + 1]);
+                }
+                if (ordered != nullptr)
+                {
+                    ordered->insert(ordered->end(), route.begin() + start, route.begin() + i);
                 }
             }
+            if (ordered != nullptr)
+            {
+                ordered->push_back(0);
+            }
+            start = i + 1;
         }
-
-        return cost;
+        return total;
     }
 };
 
@@ -273,31 +518,123 @@ int main(int argc, char *argv[])
     {
         if (argc < 2)
         {
-            std::cerr << "Usage: " << argv[0] << " <input file>" << std::endl;
+            std::cerr << "Usage: " << argv[0] << " <input file> [vehicle capacity] [max cities per route] [--shortest-paths] [--output text|json|csv] [--deterministic] [--numa] [--affinity <cpu list>] [--trip-cache-mb <n>] [--telemetry <file|unix:path> [--telemetry-interval <ms>]]" << std::endl;
             return 1;
         }
 
+        auto loadStart = std::chrono::high_resolution_clock::now();
         VRPSolver solver(argv[1]);
-        if (argc > 2)
+        double loadMillis = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - loadStart).count();
+        vrp::OutputFormat output = vrp::OutputFormat::Text;
+
+        std::vector<std::string> positional;
+        bool shortestPaths = false;
+        for (int i = 2; i < argc; ++i)
         {
-            solver.vehicleCapacity = std::stoi(argv[2]);
-            solver.maxCitiesPerRoute = std::stoi(argv[3]);
+            std::string arg = argv[i];
+            if (arg == "--shortest-paths")
+            {
+                shortestPaths = true;
+            }
+            else if (arg == "--output" && i + 1 < argc)
+            {
+                output = vrp::parseOutputFormat(argv[++i]);
+            }
+            else if (arg == "--deterministic")
+            {
+                solver.deterministic = true;
+            }
+            else if (arg == "--trip-cache-mb" && i + 1 < argc)
+            {
+                solver.tripCacheBytes = static_cast<size_t>(std::stoul(argv[++i])) << 20;
+            }
+            else if (arg == "--numa")
+            {
+                solver.numaAware = true;
+            }
+            else if (arg == "--telemetry" && i + 1 < argc)
+            {
+                solver.telemetryTarget = argv[++i];
+            }
+            else if (arg == "--telemetry-interval" && i + 1 < argc)
+            {
+                solver.telemetryIntervalMillis = std::stoi(argv[++i]);
+            }
+            else if (arg == "--affinity" && i + 1 < argc)
+            {
+                solver.numaAware = true;
+                solver.affinity = vrp::parseCpuList(argv[++i]);
+            }
+            else
+            {
+                positional.push_back(arg);
+            }
+        }
+
+        if (positional.size() >= 2)
+        {
+            solver.vehicleCapacity = std::stoi(positional[0]);
+            solver.maxCitiesPerRoute = std::stoi(positional[1]);
         }
         else
         {
             solver.getUserInput();
         }
 
-        std::cout << "Starting solver for " << solver.numberOfCities - 1 << " cities and " << solver.numberOfRoads << " routes..." << std::endl;
+        if (output == vrp::OutputFormat::Text)
+        {
+            std::cout << "Starting solver for " << solver.numberOfCities - 1 << " cities and " << solver.numberOfRoads << " routes..." << std::endl;
+        }
+        double pathsMillis = 0;
+        if (shortestPaths)
+        {
+            auto pathsStart = std::chrono::high_resolution_clock::now();
+            solver.useShortestPaths();
+            auto pathsTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - pathsStart);
+            pathsMillis = pathsTime.count() / 1000.0;
+            if (output == vrp::OutputFormat::Text)
+            {
+                std::cout << "Shortest paths (" << (solver.usedFloydWarshall() ? "Floyd-Warshall" : "Dijkstra") << "): " << pathsTime.count() << " microseconds" << std::endl;
+            }
+        }
+
         auto startTime = std::chrono::high_resolution_clock::now();
         solver.solve();
         auto endTime = std::chrono::high_resolution_clock::now();
 
+        if (output != vrp::OutputFormat::Text)
+        {
+            vrp::RunResult result;
+            result.engine = "global-search-omp";
+            result.instance = argv[1];
+            result.cities = solver.numberOfCities - 1;
+            result.roads = solver.numberOfRoads;
+            result.vehicleCapacity = solver.vehicleCapacity;
+            result.maxCitiesPerRoute = solver.maxCitiesPerRoute;
+            result.cost = solver.lowerCost;
+            result.routes = vrp::splitTrips(solver.expandedRoute(solver.bestRoute));
+            result.threads = omp_get_max_threads();
+            result.timingsMillis = {{"load", loadMillis}, {"shortestPaths", pathsMillis}, {"solve", std::chrono::duration<double, std::milli>(endTime - startTime).count()}};
+            result.counters = {{"routesEnumerated", static_cast<long long>(solver.routesEnumerated())},
+                               {"nodesExpanded", solver.telemetry->nodes()},
+                               {"routesPriced", solver.telemetry->routes()}};
+            if (solver.tripCache)
+            {
+                result.counters.push_back({"tripCacheHits", solver.tripCache->hits()});
+                result.counters.push_back({"tripCacheMisses", solver.tripCache->misses()});
+                result.counters.push_back({"tripCacheEvictions", solver.tripCache->evictions()});
+                result.counters.push_back({"tripCacheBytes", static_cast<long long>(solver.tripCache->memoryBytes())});
+            }
+            vrp::writeResult(result, output);
+            return 0;
+        }
+
         std::cout << "Lower cost: " << solver.lowerCost << std::endl;
 
-        int lastCityIndex = solver.bestRoute.size() - 1;
+        Route bestRoute = solver.expandedRoute(solver.bestRoute);
+        int lastCityIndex = bestRoute.size() - 1;
         int counter = 0;
-        for (const auto &city : solver.bestRoute)
+        for (const auto &city : bestRoute)
         {
             std::cout << city;
             if (counter < lastCityIndex)
@@ -309,6 +646,14 @@ int main(int argc, char *argv[])
         std::cout << std::endl;
         auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
         std::cout << "Time taken: " << duration.count() << " milliseconds" << std::endl;
+        if (solver.tripCache)
+        {
+            const vrp::TripCache &cache = *solver.tripCache;
+            long long lookups = cache.hits() + cache.misses();
+            std::cout << "Trip cache: " << cache.hits() << " hits, " << cache.misses() << " misses ("
+                      << (lookups > 0 ? 100 * cache.hits() / lookups : 0) << "% hit rate), " << cache.evictions() << " evictions, "
+                      << cache.memoryBytes() / 1024 << " KB" << std::endl;
+        }
     }
     catch (const std::exception &e)
     {
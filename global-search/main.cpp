@@ -8,9 +8,26 @@
 #include <map>
 #include <chrono>
 #include <tuple>
+#include <climits>
+#include <cstdio>
+#include <csignal>
+#include <memory>
+#include <sys/resource.h>
+
+#include "../vrp-lib/checkpoint.hpp"
+#include "../vrp-lib/fixed_size_solver.hpp"
+#include "../vrp-lib/packed_route.hpp"
+#include "../vrp-lib/result_writer.hpp"
+#include "../vrp-lib/route_hash_set.hpp"
+#include "../vrp-lib/route_spill.hpp"
+#include "../vrp-lib/shortest_paths.hpp"
+#include "../vrp-lib/time_windows.hpp"
+#include "../vrp-lib/trip_cache.hpp"
 
 using Route = std::vector<int>;
 
+volatile std::sig_atomic_t stopRequested = 0;
+
 struct City
 {
     int number;
@@ -36,7 +53,22 @@ class VRPSolver
 private:
     std::vector<City> cities;
     std::vector<Road> roads;
-    std::vector<Route> routes;
+    vrp::PackedRoutes routes; // complete routes, one fixed-size record each
+    std::vector<int> roadCosts; // numberOfCities x numberOfCities, INT_MAX where there is no road
+    vrp::ShortestPaths shortestPaths;
+    bool shortestPathsEnabled = false;
+    // placesVisited, numberOfPlacesVisited, previousCity, vehicleLoad, route, departureTime
+    std::vector<std::tuple<std::set<int>, int, int, int, std::vector<int>, long long>> stack;
+    std::vector<vrp::TimeWindow> timeWindows; // indexed by city number
+    bool hasTimeWindows = false;
+    long long nodesExpanded = 0;
+    std::chrono::steady_clock::time_point lastCheckpoint;
+    std::chrono::steady_clock::duration lastCheckpointDuration{};
+    std::chrono::steady_clock::time_point solveStart;
+    static constexpr size_t SET_NODE_BYTES = 48; // one std::set<int> node with its allocator overhead
+    size_t frontierBytes = 0;                   // heap held by stack
+    std::unique_ptr<vrp::RouteSpill> spill;
+    Route bestCandidate; // bestRoute before its trips were put in cached order
 
 public:
     int lowerCost = INT_MAX;
@@ -46,10 +78,25 @@ public:
     int maxCitiesPerRoute;
     int numberOfCities;
     int numberOfRoads;
+    std::string checkpointFile;
+    int checkpointIntervalSeconds = 60;
+    bool resumeFromCheckpoint = false;
+    bool fixedSizeEnabled = true;
+    bool usedFixedSize = false;
+    int checkpointsWritten = 0;
+    long long resumedMillis = 0; // search time recorded in the checkpoint this run resumed from
+    long long checkpointMillis = 0;
+    size_t tripCacheBytes = vrp::TripCache::DEFAULT_BYTES; // 0 disables the cache
+    std::unique_ptr<vrp::TripCache> tripCache;
+    size_t memoryBudgetBytes = 0; // 0 for no budget
+    std::string spillDirectory = ".";
+    size_t peakTrackedBytes = 0;
     VRPSolver(const std::string &filename)
     {
         readInput(filename);
         cities.insert(cities.begin(), {0, 0}); // Insert a dummy city representing the depot
+        buildRoadCosts();
+        routes = vrp::PackedRoutes(numberOfCities);
     }
 
     void getUserInput()
@@ -77,9 +124,15 @@ public:
 #endif
         numberOfCities = numCities + 1;
 
+        timeWindows.assign(numCities + 1, vrp::TimeWindow());
         for (int i = 1; i <= numCities; ++i)
         {
-            file >> cities[i].number >> cities[i].package_weight;
+            vrp::TimeWindow window;
+            if (vrp::readCityLine(file, cities[i].number, cities[i].package_weight, window))
+            {
+                timeWindows.at(cities[i].number) = window;
+                hasTimeWindows = true;
+            }
         }
 
         file >> numRoutes;
@@ -97,35 +150,176 @@ public:
         file.close();
     }
 
+    void buildRoadCosts()
+    {
+        roadCosts.assign(static_cast<size_t>(numberOfCities) * numberOfCities, INT_MAX);
+        for (const auto &road : roads)
+        {
+            int &cost = roadCosts[static_cast<size_t>(road.start.number) * numberOfCities + road.destination.number];
+            if (cost == INT_MAX)
+            {
+                cost = road.cost;
+            }
+        }
+    }
+
+    // Replaces direct roads by shortest paths, so a trip may pass through other cities on its way.
+    void useShortestPaths()
+    {
+        std::vector<vrp::Edge> edges;
+        edges.reserve(roads.size());
+        for (const auto &road : roads)
+        {
+            edges.push_back({road.start.number, road.destination.number, road.cost});
+        }
+        shortestPaths.compute(numberOfCities, edges);
+        roadCosts = shortestPaths.matrix();
+        shortestPathsEnabled = true;
+    }
+
+    bool usedFloydWarshall() const
+    {
+        return shortestPaths.usedFloydWarshall();
+    }
+
+    size_t routesEnumerated() const
+    {
+        return routes.size() + (spill ? spill->routes() : 0);
+    }
+
+    long long spilledRoutes() const
+    {
+        return spill ? spill->routes() : 0;
+    }
+
+    long long spillBytes() const
+    {
+        return spill ? spill->bytes() : 0;
+    }
+
+    // The route with every leg expanded into the roads it actually drives on.
+    Route expandedRoute(const Route &route) const
+    {
+        return shortestPathsEnabled ? shortestPaths.expand(route) : route;
+    }
+
     void solve()
     {
-        std::set<int> citiesVisited;
-        citiesVisited.insert(0);
-        std::vector<int> route{0};
-        generateAllPossibleRoutesLoop(citiesVisited, route);
+        // Small instances go to the size-specialized branch and bound; it has no time windows
+        // and nothing to checkpoint, so those runs keep the enumeration below.
+        if (fixedSizeEnabled && !hasTimeWindows && checkpointFile.empty() && vrp::hasFixedSizeKernel(numberOfCities))
+        {
+            solveFixedSize();
+            return;
+        }
+        solveStart = std::chrono::steady_clock::now();
+        if (!resumeFromCheckpoint || !restoreCheckpoint())
+        {
+            std::set<int> citiesVisited;
+            citiesVisited.insert(0);
+            std::vector<int> route{0};
+            stack.emplace_back(citiesVisited, 0, 0, 0, route, 0);
+        }
+        lastCheckpoint = std::chrono::steady_clock::now();
+        for (const auto &entry : stack)
+        {
+            frontierBytes += entryBytes(entry);
+        }
+        generateAllPossibleRoutesLoop();
+        if (!checkpointFile.empty())
+        {
+            std::remove(checkpointFile.c_str());
+        }
 
-        std::set<Route> filteredRoutes = filterValidRoutes();
+        // The same customer set recurs as a trip in a huge number of complete routes, so with a
+        // cache each set is sequenced once and every route is priced with its trips in their
+        // best order. Time windows make the order part of feasibility, so they walk every route.
+        if (tripCacheBytes > 0 && !hasTimeWindows)
+        {
+            tripCache = std::make_unique<vrp::TripCache>(numberOfCities, vrp::TripCache::customerSets(numberOfCities - 1, maxCitiesPerRoute), tripCacheBytes);
+        }
+        // Spilled segments are read back and priced one at a time, then the routes still in memory.
+        if (spill)
+        {
+            spill->forEachSegment([this](const vrp::PackedRoutes &batch)
+                                  { evaluateRoutes(batch); });
+        }
+        evaluateRoutes(routes);
+    }
 
-        for (const auto &route : filteredRoutes)
+    // Equal costs go to the lexicographically smallest route, whatever the order of the batches.
+    void evaluateRoutes(const vrp::PackedRoutes &batch)
+    {
+        vrp::PackedRoutes filteredRoutes = vrp::uniqueValidRoutes(batch, numberOfCities, roadCosts);
+        Route route;
+        Route ordered;
+        for (size_t i = 0; i < filteredRoutes.size(); ++i)
         {
-            int cost = calculateRouteCost(route);
+            filteredRoutes.decode(i, route);
+            int cost = tripCache ? calculateCachedRouteCost(route, ordered) : calculateRouteCost(route);
 
-            if (cost < lowerCost)
+            if (cost < lowerCost || (cost == lowerCost && route < bestCandidate))
             {
                 lowerCost = cost;
-                bestRoute = route;
+                bestCandidate = route;
+                bestRoute = tripCache ? ordered : route;
+            }
+        }
+    }
+
+    // Heap held by one stack entry: the entry itself, its visited-set nodes and its route.
+    static size_t entryBytes(const std::tuple<std::set<int>, int, int, int, std::vector<int>, long long> &entry)
+    {
+        return sizeof(entry) + std::get<0>(entry).size() * SET_NODE_BYTES + std::get<4>(entry).capacity() * sizeof(int);
+    }
+
+    // Called after every expanded node. Past the budget the complete routes go to disk; the
+    // frontier of a DFS stays small, so it is only counted. Pricing a batch holds a filtered copy
+    // of it as well, so the store is spilled at half the budget.
+    void trackMemory()
+    {
+        size_t used = routes.memoryBytes() + frontierBytes;
+        peakTrackedBytes = std::max(peakTrackedBytes, used);
+        if (memoryBudgetBytes > 0 && used > memoryBudgetBytes / 2 && !routes.empty())
+        {
+            if (!spill)
+            {
+                spill = std::make_unique<vrp::RouteSpill>(spillDirectory, numberOfCities);
             }
+            spill->write(routes);
+            routes.clear();
+            routes.shrink_to_fit();
         }
     }
 
-    void generateAllPossibleRoutesLoop(std::set<int> &placesVisited, std::vector<int> &route)
+    void solveFixedSize()
     {
-        std::vector<std::tuple<std::set<int>, int, int, int, std::vector<int>>> stack;
-        stack.emplace_back(placesVisited, 0, 0, 0, route);
+        std::vector<int> weights(numberOfCities, 0);
+        for (const auto &city : cities)
+        {
+            weights[city.number] = city.package_weight;
+        }
+        vrp::FixedSizeResult result;
+        vrp::solveFixedSize(numberOfCities, roadCosts.data(), weights.data(), vehicleCapacity, maxCitiesPerRoute, INT_MAX, 0, result);
+        if (result.cost < INT_MAX)
+        {
+            lowerCost = result.cost;
+            bestRoute = result.path;
+        }
+        usedFixedSize = true;
+    }
 
+    void generateAllPossibleRoutesLoop()
+    {
         while (!stack.empty())
         {
-            auto [placesVisited, numberOfPlacesVisited, previousCity, vehicleLoad, route] = stack.back();
+            if (!checkpointFile.empty() && ((++nodesExpanded & 1023) == 0 || stopRequested))
+            {
+                maybeCheckpoint();
+            }
+
+            frontierBytes -= entryBytes(stack.back());
+            auto [placesVisited, numberOfPlacesVisited, previousCity, vehicleLoad, route, departureTime] = stack.back();
             stack.pop_back();
 
             for (const auto &city : cities)
@@ -152,6 +346,18 @@ public:
                     }
                 }
 
+                long long nextDepartureTime = 0;
+                if (hasTimeWindows && currentCity != 0)
+                {
+                    int travelTime = roadCosts[static_cast<size_t>(previousCity) * numberOfCities + currentCity];
+                    long long arrival = travelTime == INT_MAX ? -1 : vrp::arrivalTime(timeWindows[currentCity], departureTime, travelTime);
+                    if (arrival < 0)
+                    {
+                        continue;
+                    }
+                    nextDepartureTime = arrival + timeWindows[currentCity].service;
+                }
+
                 auto newPlacesVisited = placesVisited;
                 newPlacesVisited.insert(currentCity);
                 auto newRoute = route;
@@ -163,43 +369,105 @@ public:
                     {
                         routes.push_back(newRoute);
                     }
-                    stack.emplace_back(newPlacesVisited, 0, currentCity, 0, newRoute);
+                    stack.emplace_back(newPlacesVisited, 0, currentCity, 0, newRoute, 0);
                 }
                 else
                 {
-                    stack.emplace_back(newPlacesVisited, numberOfPlacesVisited + 1, currentCity, vehicleLoad + city.package_weight, newRoute);
+                    stack.emplace_back(newPlacesVisited, numberOfPlacesVisited + 1, currentCity, vehicleLoad + city.package_weight, newRoute, nextDepartureTime);
                 }
+                frontierBytes += entryBytes(stack.back());
             }
+            trackMemory();
         }
     }
 
-    std::set<Route> filterValidRoutes()
+    // Only called between two pops, so stack and routes are a consistent snapshot.
+    void maybeCheckpoint()
     {
-        std::set<Route> validRoutes;
+        // Keep at least 100x the last write between checkpoints so they stay under 1% of the run.
+        auto now = std::chrono::steady_clock::now();
+        auto interval = std::max<std::chrono::steady_clock::duration>(std::chrono::seconds(checkpointIntervalSeconds), 100 * lastCheckpointDuration);
+        if (!stopRequested && now - lastCheckpoint < interval)
+        {
+            return;
+        }
 
-        for (const Route &route : routes)
+        vrp::Checkpoint state;
+        state.numberOfCities = numberOfCities;
+        state.vehicleCapacity = vehicleCapacity;
+        state.maxCitiesPerRoute = maxCitiesPerRoute;
+        state.lowerCost = lowerCost;
+        state.bestRoute = bestRoute;
+        state.nodesExpanded = nodesExpanded;
+        state.elapsedMillis = resumedMillis + std::chrono::duration_cast<std::chrono::milliseconds>(now - solveStart).count();
+        state.frontier.reserve(stack.size());
+        for (const auto &entry : stack)
         {
-            bool routeIsValid = true;
-            for (size_t i = 0; i < route.size() - 1; ++i)
-            {
-                int source = route[i];
-                int destination = route[i + 1];
-                bool found = std::any_of(roads.begin(), roads.end(), [source, destination](const Road &road)
-                                         { return road.start.number == source && road.destination.number == destination; });
+            state.frontier.push_back(std::get<4>(entry));
+        }
+        state.routes = routes.unpack();
+        vrp::writeCheckpoint(checkpointFile, state);
 
-                if (!found)
-                {
-                    routeIsValid = false;
-                    break;
-                }
+        lastCheckpoint = std::chrono::steady_clock::now();
+        lastCheckpointDuration = lastCheckpoint - now;
+        checkpointMillis += std::chrono::duration_cast<std::chrono::milliseconds>(lastCheckpointDuration).count();
+        checkpointsWritten++;
+
+        if (stopRequested)
+        {
+            throw std::runtime_error("Interrupted, search state saved to " + checkpointFile + ".");
+        }
+    }
+
+    bool restoreCheckpoint()
+    {
+        vrp::Checkpoint state;
+        if (!vrp::readCheckpoint(checkpointFile, state))
+        {
+            return false;
+        }
+        if (state.numberOfCities != numberOfCities || state.vehicleCapacity != vehicleCapacity || state.maxCitiesPerRoute != maxCitiesPerRoute)
+        {
+            throw std::runtime_error("Checkpoint " + checkpointFile + " was written for a different instance.");
+        }
+
+        std::map<int, int> packageWeights;
+        for (const auto &city : cities)
+        {
+            packageWeights[city.number] = city.package_weight;
+        }
+
+        // The visited set, stop count, load and clock of a stack entry all follow from its route.
+        for (const auto &route : state.frontier)
+        {
+            std::set<int> placesVisited(route.begin(), route.end());
+            int numberOfPlacesVisited = 0;
+            int vehicleLoad = 0;
+            auto tripStart = route.end();
+            while (tripStart != route.begin() && *(tripStart - 1) != 0)
+            {
+                --tripStart;
+                numberOfPlacesVisited++;
+                vehicleLoad += packageWeights[*tripStart];
             }
-            if (routeIsValid)
+            long long departureTime = 0;
+            for (auto city = tripStart; hasTimeWindows && city != route.end(); ++city)
             {
-                validRoutes.insert(route);
+                long long arrival = vrp::arrivalTime(timeWindows[*city], departureTime, roadCosts[static_cast<size_t>(*(city - 1)) * numberOfCities + *city]);
+                departureTime = arrival + timeWindows[*city].service;
             }
+            stack.emplace_back(placesVisited, numberOfPlacesVisited, route.back(), vehicleLoad, route, departureTime);
         }
-
-        return validRoutes;
+        for (const auto &route : state.routes)
+        {
+            routes.push_back(route);
+        }
+        lowerCost = state.lowerCost;
+        bestRoute = state.bestRoute;
+        nodesExpanded = state.nodesExpanded;
+        resumedMillis = state.elapsedMillis;
+        std::cout << "Resumed from " << checkpointFile << " with " << stack.size() << " pending and " << routes.size() << " complete routes" << std::endl;
+        return true;
     }
 
     int calculateRouteCost(Route route)
@@ -210,17 +478,48 @@ public:
             int source = route[i];
             int destination = route[i + 1];
 
-            for (const auto &road : roads)
+            cost += roadCosts[static_cast<size_t>(source) * numberOfCities + destination];
+        }
+
+        return cost;
+    }
+
+    // Sums the cached optimal cost of every trip and writes the route with its trips in that
+    // order to ordered. Trips too long for the cache are walked as they are.
+    int calculateCachedRouteCost(const Route &route, Route &ordered)
+    {
+        auto cost = [this](int source, int destination)
+        {
+            return roadCosts[static_cast<size_t>(source) * numberOfCities + destination];
+        };
+        int total = 0;
+        ordered.assign(1, 0);
+        size_t start = 1;
+        for (size_t i = 1; i < route.size(); ++i)
+        {
+            if (route[i] != 0)
+            {
+                continue;
+            }
+            int count = static_cast<int>(i - start);
+            if (tripCache->cacheable(count))
             {
-                if (road.start.number == source && road.destination.number == destination)
+                vrp::CachedTrip trip = tripCache->trip(&route[start], count, cost);
+                total += trip.cost;
+                ordered.insert(ordered.end(), trip.order.begin(), trip.order.begin() + trip.length);
+            }
+            else
+            {
+                for (size_t k = start - 1; k < i; ++k)
                 {
-                    cost += road.cost;
-                    break;
+                    total += cost(route[k], route[k + 1]);
                 }
+                ordered.insert(ordered.end(), route.begin() + start, route.begin() + i);
             }
+            ordered.push_back(0);
+            start = i + 1;
         }
-
-        return cost;
+        return total;
     }
 };
 
@@ -230,32 +529,144 @@ int main(int argc, char *argv[])
     {
         if (argc < 2)
         {
-            std::cerr << "Usage: " << argv[0] << " <input file>" << std::endl;
+            std::cerr << "Usage: " << argv[0] << " <input file> [vehicle capacity] [max cities per route] [--shortest-paths] [--generic] [--trip-cache-mb <n>] [--output text|json|csv] [--checkpoint <file> [--checkpoint-interval <seconds>] [--resume]] [--memory-budget-mb <n> [--spill-dir <dir>]]" << std::endl;
             return 1;
         }
 
+        auto loadStart = std::chrono::high_resolution_clock::now();
         VRPSolver solver(argv[1]);
+        double loadMillis = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - loadStart).count();
+        vrp::OutputFormat output = vrp::OutputFormat::Text;
+
+        std::vector<std::string> positional;
+        bool shortestPaths = false;
+        for (int i = 2; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg == "--shortest-paths")
+            {
+                shortestPaths = true;
+            }
+            else if (arg == "--generic")
+            {
+                solver.fixedSizeEnabled = false;
+            }
+            else if (arg == "--trip-cache-mb" && i + 1 < argc)
+            {
+                solver.tripCacheBytes = static_cast<size_t>(std::stoul(argv[++i])) << 20;
+            }
+            else if (arg == "--output" && i + 1 < argc)
+            {
+                output = vrp::parseOutputFormat(argv[++i]);
+            }
+            else if (arg == "--checkpoint" && i + 1 < argc)
+            {
+                solver.checkpointFile = argv[++i];
+            }
+            else if (arg == "--checkpoint-interval" && i + 1 < argc)
+            {
+                solver.checkpointIntervalSeconds = std::stoi(argv[++i]);
+            }
+            else if (arg == "--resume")
+            {
+                solver.resumeFromCheckpoint = true;
+            }
+            else if (arg == "--memory-budget-mb" && i + 1 < argc)
+            {
+                solver.memoryBudgetBytes = static_cast<size_t>(std::stoul(argv[++i])) << 20;
+            }
+            else if (arg == "--spill-dir" && i + 1 < argc)
+            {
+                solver.spillDirectory = argv[++i];
+            }
+            else
+            {
+                positional.push_back(arg);
+            }
+        }
+        if (solver.resumeFromCheckpoint && solver.checkpointFile.empty())
+        {
+            throw std::runtime_error("--resume requires --checkpoint <file>.");
+        }
+        if (solver.memoryBudgetBytes > 0 && !solver.checkpointFile.empty())
+        {
+            // A checkpoint holds the complete routes in memory and on disk, not the spill segments.
+            throw std::runtime_error("--memory-budget-mb cannot be combined with --checkpoint.");
+        }
+        if (!solver.checkpointFile.empty())
+        {
+            std::signal(SIGTERM, [](int)
+                        { stopRequested = 1; });
+            std::signal(SIGINT, [](int)
+                        { stopRequested = 1; });
+        }
 
-        if (argc > 2)
+        if (positional.size() >= 2)
         {
-            solver.vehicleCapacity = std::stoi(argv[2]);
-            solver.maxCitiesPerRoute = std::stoi(argv[3]);
+            solver.vehicleCapacity = std::stoi(positional[0]);
+            solver.maxCitiesPerRoute = std::stoi(positional[1]);
         }
         else
         {
             solver.getUserInput();
         }
 
-        std::cout << "Starting solver for " << solver.numberOfCities - 1 << " cities and " << solver.numberOfRoads << " routes..." << std::endl;
+        if (output == vrp::OutputFormat::Text)
+        {
+            std::cout << "Starting solver for " << solver.numberOfCities - 1 << " cities and " << solver.numberOfRoads << " routes..." << std::endl;
+        }
+        double pathsMillis = 0;
+        if (shortestPaths)
+        {
+            auto pathsStart = std::chrono::high_resolution_clock::now();
+            solver.useShortestPaths();
+            auto pathsTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - pathsStart);
+            pathsMillis = pathsTime.count() / 1000.0;
+            if (output == vrp::OutputFormat::Text)
+            {
+                std::cout << "Shortest paths (" << (solver.usedFloydWarshall() ? "Floyd-Warshall" : "Dijkstra") << "): " << pathsTime.count() << " microseconds" << std::endl;
+            }
+        }
+
         auto startTime = std::chrono::high_resolution_clock::now();
         solver.solve();
         auto endTime = std::chrono::high_resolution_clock::now();
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        long long peakRssBytes = static_cast<long long>(usage.ru_maxrss) * 1024;
+
+        if (output != vrp::OutputFormat::Text)
+        {
+            vrp::RunResult result;
+            result.engine = "global-search";
+            result.instance = argv[1];
+            result.cities = solver.numberOfCities - 1;
+            result.roads = solver.numberOfRoads;
+            result.vehicleCapacity = solver.vehicleCapacity;
+            result.maxCitiesPerRoute = solver.maxCitiesPerRoute;
+            result.cost = solver.lowerCost;
+            result.routes = vrp::splitTrips(solver.expandedRoute(solver.bestRoute));
+            result.timingsMillis = {{"load", loadMillis}, {"shortestPaths", pathsMillis}, {"solve", std::chrono::duration<double, std::milli>(endTime - startTime).count() + solver.resumedMillis}};
+            result.counters = {{"routesEnumerated", static_cast<long long>(solver.routesEnumerated())}, {"checkpointsWritten", solver.checkpointsWritten}, {"fixedSizeKernel", solver.usedFixedSize},
+                               {"peakTrackedBytes", static_cast<long long>(solver.peakTrackedBytes)}, {"peakRssBytes", peakRssBytes},
+                               {"spilledRoutes", solver.spilledRoutes()}, {"spillBytes", solver.spillBytes()}};
+            if (solver.tripCache)
+            {
+                result.counters.push_back({"tripCacheHits", solver.tripCache->hits()});
+                result.counters.push_back({"tripCacheMisses", solver.tripCache->misses()});
+                result.counters.push_back({"tripCacheEvictions", solver.tripCache->evictions()});
+                result.counters.push_back({"tripCacheBytes", static_cast<long long>(solver.tripCache->memoryBytes())});
+            }
+            vrp::writeResult(result, output);
+            return 0;
+        }
 
         std::cout << "Lower cost: " << solver.lowerCost << std::endl;
 
-        int lastCityIndex = solver.bestRoute.size() - 1;
+        Route bestRoute = solver.expandedRoute(solver.bestRoute);
+        int lastCityIndex = bestRoute.size() - 1;
         int counter = 0;
-        for (const auto &city : solver.bestRoute)
+        for (const auto &city : bestRoute)
         {
             std::cout << city;
             if (counter < lastCityIndex)
@@ -265,8 +676,30 @@ int main(int argc, char *argv[])
             counter++;
         }
         std::cout << std::endl;
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
-        std::cout << "Time taken: " << duration.count() << " milliseconds" << std::endl;
+        // A resumed search counts the time recorded before it was interrupted as well.
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime) + std::chrono::milliseconds(solver.resumedMillis);
+        std::cout << "Time taken: " << duration.count() << " microseconds" << std::endl;
+        if (solver.tripCache)
+        {
+            const vrp::TripCache &cache = *solver.tripCache;
+            long long lookups = cache.hits() + cache.misses();
+            std::cout << "Trip cache: " << cache.hits() << " hits, " << cache.misses() << " misses ("
+                      << (lookups > 0 ? 100 * cache.hits() / lookups : 0) << "% hit rate), " << cache.evictions() << " evictions, "
+                      << cache.memoryBytes() / 1024 << " KB" << std::endl;
+        }
+        if (!solver.usedFixedSize)
+        {
+            std::cout << "Memory: " << solver.peakTrackedBytes / 1024 << " KB peak in routes and frontier, " << peakRssBytes / 1024 << " KB peak RSS";
+            if (solver.spilledRoutes() > 0)
+            {
+                std::cout << ", " << solver.spilledRoutes() << " routes spilled (" << solver.spillBytes() / 1024 << " KB on disk)";
+            }
+            std::cout << std::endl;
+        }
+        if (!solver.checkpointFile.empty())
+        {
+            std::cout << "Checkpoints: " << solver.checkpointsWritten << " written in " << solver.checkpointMillis << " milliseconds" << std::endl;
+        }
     }
     catch (const std::exception &e)
     {
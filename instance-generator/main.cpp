@@ -0,0 +1,492 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+#include "../vrp-lib/vrp_solver.hpp"
+#include "../vrp-lib/spatial_index.hpp"
+
+// SplitMix64. Every block of cities draws from its own stream derived from the seed and the
+// block index, so the output does not depend on the number of threads.
+class Random
+{
+private:
+    uint64_t state;
+
+public:
+    explicit Random(uint64_t seed) : state(seed)
+    {
+    }
+
+    uint64_t next()
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [0, 1).
+    double real()
+    {
+        return (next() >> 11) * 0x1.0p-53;
+    }
+
+    // Uniform in [low, high].
+    int between(int low, int high)
+    {
+        return low + static_cast<int>(next() % static_cast<uint64_t>(high - low + 1));
+    }
+
+    double normal(double mean, double deviation)
+    {
+        double u = std::max(real(), 1e-300);
+        return mean + deviation * std::sqrt(-2.0 * std::log(u)) * std::cos(2.0 * M_PI * real());
+    }
+};
+
+struct Demand
+{
+    std::string distribution = "uniform";
+    double a = 1;
+    double b = 10;
+
+    // "uniform:min:max", "normal:mean:deviation" or "exponential:mean", with every field given.
+    static Demand parse(const std::string &text)
+    {
+        std::vector<std::string> fields;
+        size_t begin = 0;
+        while (true)
+        {
+            size_t colon = text.find(':', begin);
+            fields.push_back(text.substr(begin, colon - begin));
+            if (colon == std::string::npos)
+            {
+                break;
+            }
+            begin = colon + 1;
+        }
+        Demand demand;
+        demand.distribution = fields[0];
+        if (demand.distribution != "uniform" && demand.distribution != "normal" && demand.distribution != "exponential")
+        {
+            throw std::invalid_argument("Unknown demand distribution " + demand.distribution + ".");
+        }
+        size_t parameters = demand.distribution == "exponential" ? 1 : 2;
+        if (fields.size() != parameters + 1)
+        {
+            throw std::invalid_argument("Demand " + text + " needs " + std::to_string(parameters) + " parameter(s).");
+        }
+        demand.a = number(fields[1], text);
+        demand.b = parameters == 2 ? number(fields[2], text) : 0;
+        if (demand.distribution == "uniform" && (demand.a < 1 || demand.b < 1 || demand.a > demand.b))
+        {
+            throw std::invalid_argument("Uniform demand needs 1 <= min <= max, got " + text + ".");
+        }
+        if (demand.distribution == "normal" && (demand.a <= 0 || demand.b < 0))
+        {
+            throw std::invalid_argument("Normal demand needs a positive mean and a non-negative deviation, got " + text + ".");
+        }
+        if (demand.distribution == "exponential" && demand.a <= 0)
+        {
+            throw std::invalid_argument("Exponential demand needs a positive mean, got " + text + ".");
+        }
+        return demand;
+    }
+
+    static double number(const std::string &field, const std::string &text)
+    {
+        size_t used = 0;
+        double value = 0;
+        try
+        {
+            value = std::stod(field, &used);
+        }
+        catch (const std::exception &)
+        {
+            used = 0;
+        }
+        if (used == 0 || used != field.size())
+        {
+            throw std::invalid_argument("Bad number \"" + field + "\" in demand " + text + ".");
+        }
+        return value;
+    }
+
+    int draw(Random &random) const
+    {
+        double value;
+        if (distribution == "uniform")
+        {
+            value = random.between(static_cast<int>(a), static_cast<int>(b));
+        }
+        else if (distribution == "normal")
+        {
+            value = std::round(random.normal(a, b));
+        }
+        else
+        {
+            value = std::ceil(-a * std::log(1.0 - random.real()));
+        }
+        return std::max(1, static_cast<int>(value));
+    }
+};
+
+class InstanceGenerator
+{
+private:
+    static constexpr int BLOCK = 1024;
+
+    std::string family;
+    int numberOfCustomers;
+    uint64_t seed;
+    vrp::ThreadPool pool;
+    std::vector<double> xs;
+    std::vector<double> ys;
+
+public:
+    double degree = 8;       // expected roads leaving each customer
+    int maxCost = 100;       // random family
+    double area = 1000;      // side of the square holding the coordinates
+    int clusters = 8;        // clustered family
+    Demand demand;
+    vrp::Instance instance;
+
+    InstanceGenerator(const std::string &family, int numberOfCustomers, uint64_t seed, unsigned threads)
+        : family(family), numberOfCustomers(numberOfCustomers), seed(seed), pool(threads)
+    {
+        if (family != "random" && family != "euclidean" && family != "clustered" && family != "sparse")
+        {
+            throw std::invalid_argument("Unknown family " + family + ".");
+        }
+        if (numberOfCustomers < 1)
+        {
+            throw std::invalid_argument("The instance needs at least one customer.");
+        }
+    }
+
+    void generate()
+    {
+        instance.numberOfCustomers = numberOfCustomers;
+        instance.packageWeights.assign(numberOfCustomers + 1, 0);
+        instance.roads.clear();
+        Random demands(stream(~0ULL));
+        for (int city = 1; city <= numberOfCustomers; ++city)
+        {
+            instance.packageWeights[city] = demand.draw(demands);
+        }
+
+        if (family != "random")
+        {
+            placeCities();
+        }
+
+        size_t blocks = (numberOfCustomers + BLOCK) / BLOCK;
+        std::vector<std::vector<vrp::Edge>> blockRoads(blocks);
+        std::unique_ptr<vrp::SpatialIndex> index;
+        if (family == "euclidean" || family == "clustered")
+        {
+            index = std::make_unique<vrp::SpatialIndex>(xs, ys, instance.packageWeights);
+        }
+
+        pool.parallelFor(blocks, [&](size_t block, unsigned)
+                         {
+            Random random(stream(block));
+            int first = block * BLOCK;
+            int last = std::min<int>(first + BLOCK, numberOfCustomers + 1);
+            for (int city = first; city < last; ++city)
+            {
+                if (family == "random")
+                {
+                    randomRoads(city, random, blockRoads[block]);
+                }
+                else if (family == "sparse")
+                {
+                    gridRoads(city, random, blockRoads[block]);
+                }
+                else
+                {
+                    nearestRoads(city, *index, blockRoads[block]);
+                }
+            } });
+
+        size_t total = 0;
+        for (const auto &roads : blockRoads)
+        {
+            total += roads.size();
+        }
+        instance.roads.reserve(total);
+        for (auto &roads : blockRoads)
+        {
+            instance.roads.insert(instance.roads.end(), roads.begin(), roads.end());
+            std::vector<vrp::Edge>().swap(roads);
+        }
+    }
+
+    // Coordinate input for local-search --coordinates: n, then "number weight x y" for 0..n.
+    void writeCoordinates(const std::string &filename) const
+    {
+        if (xs.empty())
+        {
+            throw std::runtime_error("The random family has no coordinates.");
+        }
+        std::ofstream file(filename);
+        file << numberOfCustomers << '\n';
+        for (int city = 0; city <= numberOfCustomers; ++city)
+        {
+            file << city << ' ' << instance.packageWeights[city] << ' ' << xs[city] << ' ' << ys[city] << '\n';
+        }
+        if (!file)
+        {
+            throw std::runtime_error("Failed to write " + filename + ".");
+        }
+    }
+
+private:
+    uint64_t stream(uint64_t index) const
+    {
+        return Random(seed ^ (index * 0xD1B54A32D192ED03ULL)).next();
+    }
+
+    int gridSide() const
+    {
+        return static_cast<int>(std::ceil(std::sqrt(numberOfCustomers + 1.0)));
+    }
+
+    // The depot sits in the middle of the area.
+    void placeCities()
+    {
+        xs.assign(numberOfCustomers + 1, area / 2);
+        ys.assign(numberOfCustomers + 1, area / 2);
+        Random random(stream(~1ULL));
+        std::vector<std::pair<double, double>> centres(clusters);
+        for (auto &centre : centres)
+        {
+            centre = {random.real() * area, random.real() * area};
+        }
+        int side = gridSide();
+        double spacing = area / side;
+        for (int city = 1; city <= numberOfCustomers; ++city)
+        {
+            if (family == "clustered")
+            {
+                const auto &centre = centres[random.next() % clusters];
+                xs[city] = std::clamp(random.normal(centre.first, area / 20), 0.0, area);
+                ys[city] = std::clamp(random.normal(centre.second, area / 20), 0.0, area);
+            }
+            else if (family == "sparse")
+            {
+                // Jittered grid; city c takes cell c of a side x side grid, the depot takes cell 0.
+                xs[city] = ((city % side) + 0.25 + 0.5 * random.real()) * spacing;
+                ys[city] = ((city / side) + 0.25 + 0.5 * random.real()) * spacing;
+            }
+            else
+            {
+                xs[city] = random.real() * area;
+                ys[city] = random.real() * area;
+            }
+        }
+        if (family == "sparse")
+        {
+            xs[0] = ys[0] = 0.5 * spacing;
+        }
+    }
+
+    int distance(int a, int b) const
+    {
+        return std::max(1, vrp::euclideanCost(xs[a], ys[a], xs[b], ys[b]));
+    }
+
+    // Symmetric roads between every pair with probability degree / n, drawn with geometric
+    // skips so the work is proportional to the roads produced. The depot reaches everyone.
+    void randomRoads(int city, Random &random, std::vector<vrp::Edge> &roads) const
+    {
+        if (city == 0)
+        {
+            for (int other = 1; other <= numberOfCustomers; ++other)
+            {
+                int cost = random.between(1, maxCost);
+                roads.push_back({0, other, cost});
+                roads.push_back({other, 0, cost});
+            }
+            return;
+        }
+        double probability = std::min(1.0, degree / std::max(1, numberOfCustomers - 1));
+        double logMiss = std::log(1.0 - probability);
+        for (long long other = city;;)
+        {
+            other += probability >= 1.0 ? 1 : 1 + static_cast<long long>(std::log(1.0 - random.real()) / logMiss);
+            if (other > numberOfCustomers)
+            {
+                break;
+            }
+            int cost = random.between(1, maxCost);
+            roads.push_back({city, static_cast<int>(other), cost});
+            roads.push_back({static_cast<int>(other), city, cost});
+        }
+    }
+
+    // Roads to the `degree` nearest customers, costed by distance; the depot reaches everyone.
+    void nearestRoads(int city, const vrp::SpatialIndex &index, std::vector<vrp::Edge> &roads) const
+    {
+        if (city == 0)
+        {
+            for (int other = 1; other <= numberOfCustomers; ++other)
+            {
+                roads.push_back({0, other, distance(0, other)});
+                roads.push_back({other, 0, distance(other, 0)});
+            }
+            return;
+        }
+        for (int other : index.kNearest(city, static_cast<int>(degree)))
+        {
+            roads.push_back({city, other, distance(city, other)});
+        }
+    }
+
+    // Road network: two-way streets to the right and lower grid neighbours, each slowed by up
+    // to 50%, plus rare long shortcuts so the graph is not a perfect lattice. The depot only
+    // connects to its neighbours; solve these with --shortest-paths.
+    void gridRoads(int city, Random &random, std::vector<vrp::Edge> &roads) const
+    {
+        int side = gridSide();
+        auto connect = [&](int other)
+        {
+            int cost = static_cast<int>(distance(city, other) * (1.0 + 0.5 * random.real()));
+            roads.push_back({city, other, cost});
+            roads.push_back({other, city, cost});
+        };
+        if (city % side + 1 < side && city + 1 <= numberOfCustomers)
+        {
+            connect(city + 1);
+        }
+        if (city + side <= numberOfCustomers)
+        {
+            connect(city + side);
+        }
+        if (city > 0 && random.real() < 0.01 * degree / 8)
+        {
+            int other = random.between(1, numberOfCustomers);
+            if (other != city)
+            {
+                connect(other);
+            }
+        }
+    }
+};
+
+void printUsage(const char *program)
+{
+    std::cerr << "Usage: " << program << " <random|euclidean|clustered|sparse> <cities> <output file> [--degree D] [--max-cost C] [--clusters K]"
+              << " [--demand uniform:min:max|normal:mean:sd|exponential:mean] [--seed S] [--threads T] [--format text|binary|coordinates]" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        if (argc < 4)
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        std::string family = argv[1];
+        int numberOfCustomers = std::stoi(argv[2]);
+        std::string output = argv[3];
+        uint64_t seed = 1;
+        unsigned threads = std::thread::hardware_concurrency();
+        std::string format = "text";
+        double degree = 8;
+        int maxCost = 100;
+        int clusters = 8;
+        std::string demand = "uniform:1:10";
+        for (int i = 4; i < argc; i += 2)
+        {
+            std::string arg = argv[i];
+            if (i + 1 == argc)
+            {
+                throw std::invalid_argument("Option " + arg + " needs a value.");
+            }
+            std::string value = argv[i + 1];
+            if (arg == "--degree")
+            {
+                degree = std::stod(value);
+            }
+            else if (arg == "--max-cost")
+            {
+                maxCost = std::stoi(value);
+            }
+            else if (arg == "--clusters")
+            {
+                clusters = std::stoi(value);
+            }
+            else if (arg == "--demand")
+            {
+                demand = value;
+            }
+            else if (arg == "--seed")
+            {
+                seed = std::stoull(value);
+            }
+            else if (arg == "--threads")
+            {
+                threads = std::stoi(value);
+            }
+            else if (arg == "--format")
+            {
+                format = value;
+            }
+            else
+            {
+                throw std::invalid_argument("Unknown option " + arg + ".");
+            }
+        }
+        if (format != "text" && format != "binary" && format != "coordinates")
+        {
+            throw std::invalid_argument("Unknown format " + format + ".");
+        }
+
+        InstanceGenerator generator(family, numberOfCustomers, seed, std::max(1u, threads));
+        generator.degree = degree;
+        generator.maxCost = maxCost;
+        generator.clusters = std::max(1, clusters);
+        generator.demand = Demand::parse(demand);
+
+        auto startTime = std::chrono::high_resolution_clock::now();
+        generator.generate();
+        auto generatedTime = std::chrono::high_resolution_clock::now();
+        if (format == "coordinates")
+        {
+            generator.writeCoordinates(output);
+        }
+        else
+        {
+            vrp::writeInstance(output, generator.instance, format == "binary");
+        }
+        auto endTime = std::chrono::high_resolution_clock::now();
+
+        std::cout << "Generated " << numberOfCustomers << " cities and " << generator.instance.roads.size() << " roads in "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(generatedTime - startTime).count() << " milliseconds, written in "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(endTime - generatedTime).count() << " milliseconds" << std::endl;
+    }
+    catch (const std::invalid_argument &e)
+    {
+        // Also thrown by std::stoi and friends for a value that is not a number.
+        std::cerr << "Error: " << e.what() << std::endl;
+        printUsage(argv[0]);
+        return 1;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -7,10 +7,14 @@
 #include <set>
 #include <map>
 #include <chrono>
+#include <tuple>
 #include <mpi.h>
 #include <omp.h>
 #include <climits>
 
+#include "../vrp-lib/result_writer.hpp"
+#include "../vrp-lib/shortest_paths.hpp"
+
 using Route = std::vector<int>;
 
 struct City
@@ -41,10 +45,15 @@ private:
     int vehicleCapacity;
     int maxCitiesPerRoute;
     std::map<int, std::vector<std::pair<int, int>>> adjList;
+    int numberOfCities;
+    std::vector<int> roadCosts; // numberOfCities x numberOfCities, INT_MAX where there is no road
+    vrp::ShortestPaths shortestPaths;
+    bool shortestPathsEnabled = false;
 
 public:
     int lowerCost = INT_MAX;
     std::vector<Route> bestRoutes;
+    bool deterministic = false;
 
     VRPSolver(const std::string &filename, int vehicleCapacity, int maxCitiesPerRoute)
         : vehicleCapacity(vehicleCapacity), maxCitiesPerRoute(maxCitiesPerRoute)
@@ -65,6 +74,7 @@ public:
         int numCities, numRoutes;
         file >> numCities;
         cities.resize(numCities + 1);
+        numberOfCities = numCities + 1;
 
         for (int i = 1; i <= numCities; ++i)
         {
@@ -85,10 +95,57 @@ public:
 
     void buildAdjacencyList()
     {
+        roadCosts.assign(static_cast<size_t>(numberOfCities) * numberOfCities, INT_MAX);
         for (const auto &road : roads)
         {
             adjList[road.start.number].emplace_back(road.destination.number, road.cost);
+            int &cost = roadCosts[static_cast<size_t>(road.start.number) * numberOfCities + road.destination.number];
+            if (cost == INT_MAX)
+            {
+                cost = road.cost;
+            }
+        }
+    }
+
+    // Replaces direct roads by shortest paths, so findNextRoute() can reach any city that is
+    // reachable at all instead of only direct neighbours.
+    void useShortestPaths()
+    {
+        std::vector<vrp::Edge> edges;
+        edges.reserve(roads.size());
+        for (const auto &road : roads)
+        {
+            edges.push_back({road.start.number, road.destination.number, road.cost});
+        }
+        shortestPaths.compute(numberOfCities, edges);
+        roadCosts = shortestPaths.matrix();
+        adjList.clear();
+        for (const auto &edge : shortestPaths.closureRoads())
+        {
+            adjList[edge.start].emplace_back(edge.destination, edge.cost);
         }
+        shortestPathsEnabled = true;
+    }
+
+    bool usedFloydWarshall() const
+    {
+        return shortestPaths.usedFloydWarshall();
+    }
+
+    int customers() const
+    {
+        return numberOfCities - 1;
+    }
+
+    size_t roadCount() const
+    {
+        return roads.size();
+    }
+
+    // The route with every leg expanded into the roads it actually drives on.
+    Route expandedRoute(const Route &route) const
+    {
+        return shortestPathsEnabled ? shortestPaths.expand(route) : route;
     }
 
     void solve()
@@ -100,6 +157,9 @@ public:
         std::vector<Route> localBestRoutes;
         int localTotalCost = 0;
 
+        // Deterministic runs merge the routes in task order instead of thread arrival order.
+        std::vector<Route> taskRoutes(deterministic ? cities.size() - 1 : 0);
+
 #pragma omp parallel
         {
             std::vector<Route> threadBestRoutes;
@@ -117,6 +177,11 @@ public:
                 route.insert(route.begin(), 0);
                 route.push_back(0);
                 route = twoOpt(route);
+                if (deterministic)
+                {
+                    taskRoutes[i] = route;
+                    continue;
+                }
                 int routeCost = calculateRouteCost(route);
                 threadTotalCost += routeCost;
                 threadBestRoutes.push_back(route);
@@ -129,6 +194,15 @@ public:
             }
         }
 
+        for (const Route &route : taskRoutes)
+        {
+            if (!route.empty())
+            {
+                localTotalCost += calculateRouteCost(route);
+                localBestRoutes.push_back(route);
+            }
+        }
+
         lowerCost = localTotalCost;
         bestRoutes = localBestRoutes;
     }
@@ -174,14 +248,10 @@ public:
         int cost = 0;
         for (size_t i = 0; i < route.size() - 1; ++i)
         {
-            int source = route[i];
-            int destination = route[i + 1];
-            auto it = std::find_if(adjList[source].begin(), adjList[source].end(),
-                                   [destination](const std::pair<int, int> &p)
-                                   { return p.first == destination; });
-            if (it != adjList[source].end())
+            int roadCost = roadCosts[static_cast<size_t>(route[i]) * numberOfCities + route[i + 1]];
+            if (roadCost != INT_MAX)
             {
-                cost += it->second;
+                cost += roadCost;
             }
         }
         return cost;
@@ -189,6 +259,10 @@ public:
 
     Route twoOpt(const Route &route)
     {
+        if (deterministic)
+        {
+            return twoOptBestImprovement(route);
+        }
         Route newRoute = route;
         int bestCost = calculateRouteCost(route);
         bool improvement = true;
@@ -220,6 +294,58 @@ public:
         return newRoute;
     }
 
+    // Every pass prices all moves against the same route and applies the cheapest one, ties going
+    // to the smallest (i, j), so the result is the same for any thread count or schedule.
+    Route twoOptBestImprovement(const Route &route)
+    {
+        Route newRoute = route;
+        int bestCost = calculateRouteCost(route);
+
+        while (true)
+        {
+            int moveCost = bestCost;
+            size_t moveI = 0;
+            size_t moveJ = 0;
+
+#pragma omp parallel
+            {
+                int threadCost = bestCost;
+                size_t threadI = 0;
+                size_t threadJ = 0;
+
+#pragma omp for schedule(dynamic) nowait
+                for (size_t i = 1; i < newRoute.size() - 2; ++i)
+                {
+                    for (size_t j = i + 1; j < newRoute.size() - 1; ++j)
+                    {
+                        int candidateCost = calculateRouteCost(twoOptSwap(newRoute, i, j));
+                        if (candidateCost < bestCost && (threadI == 0 || std::tie(candidateCost, i, j) < std::tie(threadCost, threadI, threadJ)))
+                        {
+                            threadCost = candidateCost;
+                            threadI = i;
+                            threadJ = j;
+                        }
+                    }
+                }
+
+#pragma omp critical
+                if (threadI != 0 && (moveI == 0 || std::tie(threadCost, threadI, threadJ) < std::tie(moveCost, moveI, moveJ)))
+                {
+                    moveCost = threadCost;
+                    moveI = threadI;
+                    moveJ = threadJ;
+                }
+            }
+
+            if (moveI == 0)
+            {
+                return newRoute;
+            }
+            newRoute = twoOptSwap(newRoute, moveI, moveJ);
+            bestCost = moveCost;
+        }
+    }
+
     Route twoOptSwap(const Route &route, int i, int k)
     {
         Route newRoute(route.begin(), route.begin() + i);
@@ -243,7 +369,7 @@ int main(int argc, char *argv[])
         {
             if (rank == 0)
             {
-                std::cerr << "Usage: " << argv[0] << " <input file> <vehicle capacity> <max cities per route>" << std::endl;
+                std::cerr << "Usage: " << argv[0] << " <input file> <vehicle capacity> <max cities per route> [--shortest-paths] [--output text|json|csv] [--deterministic]" << std::endl;
             }
             MPI_Finalize();
             return 1;
@@ -252,8 +378,41 @@ int main(int argc, char *argv[])
         std::string filename = argv[1];
         int vehicleCapacity = std::stoi(argv[2]);
         int maxCitiesPerRoute = std::stoi(argv[3]);
+        bool shortestPaths = false;
+        vrp::OutputFormat output = vrp::OutputFormat::Text;
+        bool deterministic = false;
+        for (int i = 4; i < argc; ++i)
+        {
+            if (std::string(argv[i]) == "--shortest-paths")
+            {
+                shortestPaths = true;
+            }
+            else if (std::string(argv[i]) == "--output" && i + 1 < argc)
+            {
+                output = vrp::parseOutputFormat(argv[++i]);
+            }
+            else if (std::string(argv[i]) == "--deterministic")
+            {
+                deterministic = true;
+            }
+        }
 
+        auto loadStart = std::chrono::high_resolution_clock::now();
         VRPSolver solver(filename, vehicleCapacity, maxCitiesPerRoute);
+        solver.deterministic = deterministic;
+        double loadMillis = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - loadStart).count();
+        double pathsMillis = 0;
+        if (shortestPaths)
+        {
+            auto pathsStart = std::chrono::high_resolution_clock::now();
+            solver.useShortestPaths();
+            auto pathsTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - pathsStart);
+            pathsMillis = pathsTime.count() / 1000.0;
+            if (rank == 0 && output == vrp::OutputFormat::Text)
+            {
+                std::cout << "Shortest paths (" << (solver.usedFloydWarshall() ? "Floyd-Warshall" : "Dijkstra") << "): " << pathsTime.count() << " microseconds" << std::endl;
+            }
+        }
 
         auto startTime = std::chrono::high_resolution_clock::now();
         solver.solve();
@@ -262,16 +421,33 @@ int main(int argc, char *argv[])
         int globalLowerCost;
         MPI_Reduce(&solver.lowerCost, &globalLowerCost, 1, MPI_INT, MPI_MIN, 0, MPI_COMM_WORLD);
 
-        if (rank == 0)
-        {
-            std::cout << "Lower cost: " << globalLowerCost << std::endl;
-        }
-
         std::vector<int> allLowerCosts(size);
         MPI_Gather(&solver.lowerCost, 1, MPI_INT, allLowerCosts.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
 
-        if (rank == 0)
+        if (rank == 0 && output != vrp::OutputFormat::Text)
+        {
+            vrp::RunResult result;
+            result.engine = "local-search-mpi";
+            result.instance = filename;
+            result.cities = solver.customers();
+            result.roads = solver.roadCount();
+            result.vehicleCapacity = vehicleCapacity;
+            result.maxCitiesPerRoute = maxCitiesPerRoute;
+            result.cost = globalLowerCost;
+            for (const Route &route : solver.bestRoutes)
+            {
+                result.routes.push_back(solver.expandedRoute(route));
+            }
+            result.threads = omp_get_max_threads();
+            result.ranks = size;
+            result.rankCosts.assign(allLowerCosts.begin(), allLowerCosts.end());
+            result.timingsMillis = {{"load", loadMillis}, {"shortestPaths", pathsMillis}, {"solve", std::chrono::duration<double, std::milli>(endTime - startTime).count()}};
+            result.counters = {{"trips", static_cast<long long>(solver.bestRoutes.size())}};
+            vrp::writeResult(result, output);
+        }
+        else if (rank == 0)
         {
+            std::cout << "Lower cost: " << globalLowerCost << std::endl;
             for (int i = 0; i < size; ++i)
             {
                 std::cout << "Process " << i << " cost: " << allLowerCosts[i] << std::endl;
@@ -280,7 +456,7 @@ int main(int argc, char *argv[])
             int routesLength = solver.bestRoutes.size();
             for (const Route &route : solver.bestRoutes)
             {
-                for (int city : route)
+                for (int city : solver.expandedRoute(route))
                 {
                     std::cout << city << " ";
                 }
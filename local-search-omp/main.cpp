@@ -7,8 +7,16 @@
 #include <set>
 #include <map>
 #include <chrono>
+#include <tuple>
 #include <omp.h>
 #include <climits>
+#include <memory>
+
+#include "../vrp-lib/numa.hpp"
+#include "../vrp-lib/parallel_two_opt.hpp"
+#include "../vrp-lib/result_writer.hpp"
+#include "../vrp-lib/shortest_paths.hpp"
+#include "../vrp-lib/trip_cache.hpp"
 
 using Route = std::vector<int>;
 
@@ -40,10 +48,21 @@ private:
     int vehicleCapacity;
     int maxCitiesPerRoute;
     std::map<int, std::vector<std::pair<int, int>>> adjList;
+    int numberOfCities;
+    std::vector<int> roadCosts; // numberOfCities x numberOfCities, INT_MAX where there is no road
+    vrp::ShortestPaths shortestPaths;
+    bool shortestPathsEnabled = false;
+    static constexpr long long MISSING_ROAD_COST = 1000000000;
 
 public:
     int lowerCost = INT_MAX;
     std::vector<Route> bestRoutes;
+    bool deterministic = false;
+    size_t tripCacheBytes = 0; // opt-in with --trip-cache-mb
+    int parallelTwoOptScans = 0; // trips long enough for the parallel 2-opt scan
+    bool numaAware = false;
+    std::vector<int> affinity; // cpu of every thread, empty for the default spread
+    std::unique_ptr<vrp::TripCache> tripCache;
 
     VRPSolver(const std::string &filename, int vehicleCapacity, int maxCitiesPerRoute)
         : vehicleCapacity(vehicleCapacity), maxCitiesPerRoute(maxCitiesPerRoute)
@@ -64,6 +83,7 @@ public:
         int numCities, numRoutes;
         file >> numCities;
         cities.resize(numCities + 1);
+        numberOfCities = numCities + 1;
 
         for (int i = 1; i <= numCities; ++i)
         {
@@ -84,22 +104,99 @@ public:
 
     void buildAdjacencyList()
     {
+        roadCosts.assign(static_cast<size_t>(numberOfCities) * numberOfCities, INT_MAX);
         for (const auto &road : roads)
         {
             adjList[road.start.number].emplace_back(road.destination.number, road.cost);
+            int &cost = roadCosts[static_cast<size_t>(road.start.number) * numberOfCities + road.destination.number];
+            if (cost == INT_MAX)
+            {
+                cost = road.cost;
+            }
+        }
+    }
+
+    // Replaces direct roads by shortest paths, so findNextRoute() can reach any city that is
+    // reachable at all instead of only direct neighbours.
+    void useShortestPaths()
+    {
+        std::vector<vrp::Edge> edges;
+        edges.reserve(roads.size());
+        for (const auto &road : roads)
+        {
+            edges.push_back({road.start.number, road.destination.number, road.cost});
+        }
+        shortestPaths.compute(numberOfCities, edges);
+        roadCosts = shortestPaths.matrix();
+        adjList.clear();
+        for (const auto &edge : shortestPaths.closureRoads())
+        {
+            adjList[edge.start].emplace_back(edge.destination, edge.cost);
+        }
+        shortestPathsEnabled = true;
+    }
+
+    bool usedFloydWarshall() const
+    {
+        return shortestPaths.usedFloydWarshall();
+    }
+
+    int customers() const
+    {
+        return numberOfCities - 1;
+    }
+
+    size_t roadCount() const
+    {
+        return roads.size();
+    }
+
+    // The route with every leg expanded into the roads it actually drives on.
+    Route expandedRoute(const Route &route) const
+    {
+        return shortestPathsEnabled ? shortestPaths.expand(route) : route;
+    }
+
+    // Pins every OpenMP thread the way global-search-omp --numa does. The cost matrix is not
+    // replicated: construction walks the adjacency lists and 2-opt reads a few rows per trip,
+    // so matrix reads are not the bandwidth-bound part they are there.
+    void pinThreads()
+    {
+        vrp::NumaTopology topology = vrp::NumaTopology::detect();
+#pragma omp parallel
+        {
+            int thread = omp_get_thread_num();
+            int cpu = topology.cpuForThread(thread, affinity);
+            if (!vrp::pinCurrentThread(cpu))
+            {
+#pragma omp critical
+                std::cerr << "Warning: could not pin thread " << thread << " to CPU " << cpu << "." << std::endl;
+            }
         }
     }
 
     void solve()
     {
+        if (numaAware)
+        {
+            pinThreads();
+        }
         std::set<int> visitedCities;
         visitedCities.insert(0);
         int totalCost = 0;
 
+        // Deterministic runs merge the routes in task order instead of thread arrival order.
+        std::vector<Route> taskRoutes(deterministic ? cities.size() - 1 : 0);
+        // Every task starts from the same visited set, so threads keep building the same trips;
+        // the shared cache sequences each of them once.
+        if (tripCacheBytes > 0)
+        {
+            tripCache = std::make_unique<vrp::TripCache>(numberOfCities, numberOfCities - 1, tripCacheBytes);
+        }
+
 #pragma omp parallel
         {
             std::vector<Route> localBestRoutes;
-            int localTotalCost = 0;
 
 #pragma omp for schedule(dynamic)
             for (int i = 0; i < cities.size() - 1; ++i)
@@ -112,19 +209,36 @@ public:
                 }
                 route.insert(route.begin(), 0);
                 route.push_back(0);
-                route = twoOpt(route);
-                int routeCost = calculateRouteCost(route);
-                localTotalCost += routeCost;
+                route = sequenceTrip(route);
+                if (deterministic)
+                {
+                    taskRoutes[i] = route;
+                    continue;
+                }
                 localBestRoutes.push_back(route);
             }
 
 #pragma omp critical
+            bestRoutes.insert(bestRoutes.end(), localBestRoutes.begin(), localBestRoutes.end());
+        }
+
+        for (const Route &route : taskRoutes)
+        {
+            if (!route.empty())
             {
-                totalCost += localTotalCost;
-                bestRoutes.insert(bestRoutes.end(), localBestRoutes.begin(), localBestRoutes.end());
+                bestRoutes.push_back(route);
             }
         }
 
+        // 2-opt runs after the construction region, so a trip long enough for the parallel scan
+        // gets every thread instead of the single one that built it.
+        parallelTwoOptScans = vrp::twoOptTrips(bestRoutes, [this](int source, int destination)
+                                               { return legCost(source, destination); });
+        for (const Route &route : bestRoutes)
+        {
+            totalCost += calculateRouteCost(route);
+        }
+
         lowerCost = totalCost;
     }
 
@@ -169,58 +283,40 @@ public:
         int cost = 0;
         for (size_t i = 0; i < route.size() - 1; ++i)
         {
-            int source = route[i];
-            int destination = route[i + 1];
-            auto it = std::find_if(adjList[source].begin(), adjList[source].end(),
-                                   [destination](const std::pair<int, int> &p)
-                                   { return p.first == destination; });
-            if (it != adjList[source].end())
+            int roadCost = roadCosts[static_cast<size_t>(route[i]) * numberOfCities + route[i + 1]];
+            if (roadCost != INT_MAX)
             {
-                cost += it->second;
+                cost += roadCost;
             }
         }
         return cost;
     }
 
-    Route twoOpt(const Route &route)
+    // Trips short enough for the trip cache take the optimal order of their customers; solve()
+    // improves every trip with 2-opt afterwards, which leaves those orders unchanged.
+    Route sequenceTrip(const Route &route)
     {
-        Route newRoute = route;
-        int bestCost = calculateRouteCost(route);
-        bool improvement = true;
-
-        while (improvement)
+        int count = static_cast<int>(route.size()) - 2;
+        if (tripCache && tripCache->cacheable(count))
         {
-            improvement = false;
-
-#pragma omp parallel for schedule(dynamic)
-            for (size_t i = 1; i < route.size() - 2; ++i)
+            vrp::CachedTrip trip = tripCache->trip(&route[1], count, [this](int source, int destination)
+                                                   { return roadCosts[static_cast<size_t>(source) * numberOfCities + destination]; });
+            if (trip.cost != INT_MAX)
             {
-                for (size_t j = i + 1; j < route.size() - 1; ++j)
-                {
-                    Route candidate = twoOptSwap(newRoute, i, j);
-                    int candidateCost = calculateRouteCost(candidate);
-                    if (candidateCost < bestCost)
-                    {
-#pragma omp critical
-                        {
-                            newRoute = candidate;
-                            bestCost = candidateCost;
-                            improvement = true;
-                        }
-                    }
-                }
+                Route ordered{0};
+                ordered.insert(ordered.end(), trip.order.begin(), trip.order.begin() + trip.length);
+                ordered.push_back(0);
+                return ordered;
             }
         }
-
-        return newRoute;
+        return route;
     }
 
-    Route twoOptSwap(const Route &route, int i, int k)
+    // Missing roads cost more than any real route, so moves never introduce them.
+    long long legCost(int source, int destination) const
     {
-        Route newRoute(route.begin(), route.begin() + i);
-        std::reverse_copy(route.begin() + i, route.begin() + k + 1, std::back_inserter(newRoute));
-        std::copy(route.begin() + k + 1, route.end(), std::back_inserter(newRoute));
-        return newRoute;
+        int cost = roadCosts[static_cast<size_t>(source) * numberOfCities + destination];
+        return cost == INT_MAX ? MISSING_ROAD_COST : cost;
     }
 };
 
@@ -230,26 +326,106 @@ int main(int argc, char *argv[])
     {
         if (argc < 4)
         {
-            std::cerr << "Usage: " << argv[0] << " <input file> <vehicle capacity> <max cities per route>" << std::endl;
+            std::cerr << "Usage: " << argv[0] << " <input file> <vehicle capacity> <max cities per route> [--shortest-paths] [--output text|json|csv] [--deterministic] [--trip-cache-mb <n>] [--numa] [--affinity <cpu list>]" << std::endl;
             return 1;
         }
 
         std::string filename = argv[1];
         int vehicleCapacity = std::stoi(argv[2]);
         int maxCitiesPerRoute = std::stoi(argv[3]);
+        bool shortestPaths = false;
+        vrp::OutputFormat output = vrp::OutputFormat::Text;
+        bool deterministic = false;
+        size_t tripCacheBytes = 0;
+        bool numaAware = false;
+        std::vector<int> affinity;
+        for (int i = 4; i < argc; ++i)
+        {
+            if (std::string(argv[i]) == "--shortest-paths")
+            {
+                shortestPaths = true;
+            }
+            else if (std::string(argv[i]) == "--output" && i + 1 < argc)
+            {
+                output = vrp::parseOutputFormat(argv[++i]);
+            }
+            else if (std::string(argv[i]) == "--deterministic")
+            {
+                deterministic = true;
+            }
+            else if (std::string(argv[i]) == "--trip-cache-mb" && i + 1 < argc)
+            {
+                tripCacheBytes = static_cast<size_t>(std::stoul(argv[++i])) << 20;
+            }
+            else if (std::string(argv[i]) == "--numa")
+            {
+                numaAware = true;
+            }
+            else if (std::string(argv[i]) == "--affinity" && i + 1 < argc)
+            {
+                numaAware = true;
+                affinity = vrp::parseCpuList(argv[++i]);
+            }
+        }
 
+        auto loadStart = std::chrono::high_resolution_clock::now();
         VRPSolver solver(filename, vehicleCapacity, maxCitiesPerRoute);
+        solver.deterministic = deterministic;
+        solver.tripCacheBytes = tripCacheBytes;
+        solver.numaAware = numaAware;
+        solver.affinity = affinity;
+        double loadMillis = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - loadStart).count();
+        double pathsMillis = 0;
+        if (shortestPaths)
+        {
+            auto pathsStart = std::chrono::high_resolution_clock::now();
+            solver.useShortestPaths();
+            auto pathsTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - pathsStart);
+            pathsMillis = pathsTime.count() / 1000.0;
+            if (output == vrp::OutputFormat::Text)
+            {
+                std::cout << "Shortest paths (" << (solver.usedFloydWarshall() ? "Floyd-Warshall" : "Dijkstra") << "): " << pathsTime.count() << " microseconds" << std::endl;
+            }
+        }
 
         auto startTime = std::chrono::high_resolution_clock::now();
         solver.solve();
         auto endTime = std::chrono::high_resolution_clock::now();
 
+        if (output != vrp::OutputFormat::Text)
+        {
+            vrp::RunResult result;
+            result.engine = "local-search-omp";
+            result.instance = filename;
+            result.cities = solver.customers();
+            result.roads = solver.roadCount();
+            result.vehicleCapacity = vehicleCapacity;
+            result.maxCitiesPerRoute = maxCitiesPerRoute;
+            result.cost = solver.lowerCost;
+            for (const Route &route : solver.bestRoutes)
+            {
+                result.routes.push_back(solver.expandedRoute(route));
+            }
+            result.threads = omp_get_max_threads();
+            result.timingsMillis = {{"load", loadMillis}, {"shortestPaths", pathsMillis}, {"solve", std::chrono::duration<double, std::milli>(endTime - startTime).count()}};
+            result.counters = {{"trips", static_cast<long long>(solver.bestRoutes.size())}, {"parallelTwoOptScans", solver.parallelTwoOptScans}};
+            if (solver.tripCache)
+            {
+                result.counters.push_back({"tripCacheHits", solver.tripCache->hits()});
+                result.counters.push_back({"tripCacheMisses", solver.tripCache->misses()});
+                result.counters.push_back({"tripCacheEvictions", solver.tripCache->evictions()});
+                result.counters.push_back({"tripCacheBytes", static_cast<long long>(solver.tripCache->memoryBytes())});
+            }
+            vrp::writeResult(result, output);
+            return 0;
+        }
+
         std::cout << "Lower cost: " << solver.lowerCost << std::endl;
 
         int routesLength = solver.bestRoutes.size();
         for (const Route &route : solver.bestRoutes)
         {
-            for (int city : route)
+            for (int city : solver.expandedRoute(route))
             {
                 std::cout << city << " ";
             }
@@ -262,6 +438,14 @@ int main(int argc, char *argv[])
         auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
 
         std::cout << "Time taken: " << duration << " nanosseconds" << std::endl;
+        if (solver.tripCache)
+        {
+            const vrp::TripCache &cache = *solver.tripCache;
+            long long lookups = cache.hits() + cache.misses();
+            std::cout << "Trip cache: " << cache.hits() << " hits, " << cache.misses() << " misses ("
+                      << (lookups > 0 ? 100 * cache.hits() / lookups : 0) << "% hit rate), " << cache.evictions() << " evictions, "
+                      << cache.memoryBytes() / 1024 << " KB" << std::endl;
+        }
     }
     catch (const std::exception &e)
     {
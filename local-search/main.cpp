@@ -7,6 +7,17 @@
 #include <set>
 #include <map>
 #include <chrono>
+#include <climits>
+#include <memory>
+
+#include "../vrp-lib/guided_local_search.hpp"
+#include "../vrp-lib/neighbor_list_search.hpp"
+#include "../vrp-lib/result_writer.hpp"
+#include "../vrp-lib/shortest_paths.hpp"
+#include "../vrp-lib/spatial_index.hpp"
+#include "../vrp-lib/thread_pool.hpp"
+#include "../vrp-lib/time_windows.hpp"
+#include "../vrp-lib/trip_cache.hpp"
 
 using Route = std::vector<int>;
 
@@ -38,19 +49,82 @@ private:
     int vehicleCapacity;
     int maxCitiesPerRoute;
     std::map<int, std::vector<std::pair<int, int>>> adjList;
+    int numberOfCities;
+    std::vector<int> roadCosts; // numberOfCities x numberOfCities, INT_MAX where there is no road
+    vrp::ShortestPaths shortestPaths;
+    bool shortestPathsEnabled = false;
+    std::vector<double> xs; // coordinate input only, costs are computed on demand
+    std::vector<double> ys;
+    std::unique_ptr<vrp::SpatialIndex> spatialIndex;
+    std::vector<vrp::TimeWindow> timeWindows; // indexed by city number
+    bool hasTimeWindows = false;
+    static constexpr long long MISSING_ROAD_COST = 1000000000;
+    static constexpr size_t NEIGHBOR_SEARCH_MIN_LENGTH = 64; // shorter trips keep the full 2-opt scan
+    static constexpr int NEIGHBOR_LIST_SIZE = 10;
+    bool symmetricCosts = true;
 
 public:
     int lowerCost = INT_MAX;
     std::vector<Route> bestRoutes;
-
-    VRPSolver(const std::string &filename, int vehicleCapacity, int maxCitiesPerRoute)
+    size_t tripCacheBytes = 0; // opt-in with --trip-cache-mb
+    std::unique_ptr<vrp::TripCache> tripCache;
+    vrp::GuidedLocalSearchOptions guidedOptions;
+    bool guided = false;
+    long long guidedIterations = 0;
+    long long guidedMoves = 0;
+    long long guidedPenalties = 0;
+    unsigned improveThreads = 0; // pool that improves trips while the next ones are built, 0 for none
+
+    VRPSolver(const std::string &filename, int vehicleCapacity, int maxCitiesPerRoute, bool coordinateInput = false)
         : vehicleCapacity(vehicleCapacity), maxCitiesPerRoute(maxCitiesPerRoute)
     {
+        if (coordinateInput)
+        {
+            readCoordinateInput(filename);
+            return;
+        }
         readInput(filename);
         cities.insert(cities.begin(), {0, 0});
         buildAdjacencyList();
     }
 
+    // Coordinate format: the number of cities, then one "number weight x y" line per city
+    // including the depot 0. No roads are stored; every pair is connected at its Euclidean cost.
+    void readCoordinateInput(const std::string &filename)
+    {
+        std::ifstream file(filename);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Failed to open input file.");
+        }
+
+        int numCities;
+        file >> numCities;
+        numberOfCities = numCities + 1;
+        cities.resize(numberOfCities);
+        xs.resize(numberOfCities);
+        ys.resize(numberOfCities);
+        std::vector<int> packageWeights(numberOfCities);
+        for (int i = 0; i < numberOfCities; ++i)
+        {
+            int number;
+            file >> number;
+            if (number < 0 || number >= numberOfCities)
+            {
+                throw std::runtime_error("City number out of range in coordinate input.");
+            }
+            file >> cities[number].package_weight >> xs[number] >> ys[number];
+            cities[number].number = number;
+            packageWeights[number] = cities[number].package_weight;
+        }
+        if (!file)
+        {
+            throw std::runtime_error("Malformed coordinate input file.");
+        }
+
+        spatialIndex = std::make_unique<vrp::SpatialIndex>(xs, ys, packageWeights);
+    }
+
     void readInput(const std::string &filename)
     {
         std::ifstream file(filename);
@@ -62,10 +136,17 @@ public:
         int numCities, numRoutes;
         file >> numCities;
         cities.resize(numCities + 1);
+        numberOfCities = numCities + 1;
 
+        timeWindows.assign(numberOfCities, vrp::TimeWindow());
         for (int i = 1; i <= numCities; ++i)
         {
-            file >> cities[i].number >> cities[i].package_weight;
+            vrp::TimeWindow window;
+            if (vrp::readCityLine(file, cities[i].number, cities[i].package_weight, window))
+            {
+                timeWindows.at(cities[i].number) = window;
+                hasTimeWindows = true;
+            }
         }
 
         file >> numRoutes;
@@ -82,10 +163,78 @@ public:
 
     void buildAdjacencyList()
     {
+        roadCosts.assign(static_cast<size_t>(numberOfCities) * numberOfCities, INT_MAX);
         for (const auto &road : roads)
         {
             adjList[road.start.number].emplace_back(road.destination.number, road.cost);
+            int &cost = roadCosts[static_cast<size_t>(road.start.number) * numberOfCities + road.destination.number];
+            if (cost == INT_MAX)
+            {
+                cost = road.cost;
+            }
         }
+        symmetricCosts = isSymmetric();
+    }
+
+    bool isSymmetric() const
+    {
+        for (int from = 0; from < numberOfCities; ++from)
+        {
+            for (int to = from + 1; to < numberOfCities; ++to)
+            {
+                if (roadCosts[static_cast<size_t>(from) * numberOfCities + to] != roadCosts[static_cast<size_t>(to) * numberOfCities + from])
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Replaces direct roads by shortest paths, so findNextRoute() can reach any city that is
+    // reachable at all instead of only direct neighbours.
+    void useShortestPaths()
+    {
+        if (spatialIndex)
+        {
+            throw std::runtime_error("--shortest-paths does not apply to coordinate input.");
+        }
+        std::vector<vrp::Edge> edges;
+        edges.reserve(roads.size());
+        for (const auto &road : roads)
+        {
+            edges.push_back({road.start.number, road.destination.number, road.cost});
+        }
+        shortestPaths.compute(numberOfCities, edges);
+        roadCosts = shortestPaths.matrix();
+        adjList.clear();
+        for (const auto &edge : shortestPaths.closureRoads())
+        {
+            adjList[edge.start].emplace_back(edge.destination, edge.cost);
+        }
+        shortestPathsEnabled = true;
+        symmetricCosts = isSymmetric();
+    }
+
+    bool usedFloydWarshall() const
+    {
+        return shortestPaths.usedFloydWarshall();
+    }
+
+    int customers() const
+    {
+        return numberOfCities - 1;
+    }
+
+    size_t roadCount() const
+    {
+        return roads.size();
+    }
+
+    // The route with every leg expanded into the roads it actually drives on.
+    Route expandedRoute(const Route &route) const
+    {
+        return shortestPathsEnabled ? shortestPaths.expand(route) : route;
     }
 
     void solve()
@@ -93,6 +242,21 @@ public:
         std::set<int> visitedCities;
         visitedCities.insert(0);
         int totalCost = 0;
+        if (tripCacheBytes > 0 && !hasTimeWindows)
+        {
+            // Trips never share a customer, so there are fewer sets than customers.
+            tripCache = std::make_unique<vrp::TripCache>(numberOfCities, numberOfCities - 1, tripCacheBytes);
+        }
+
+        // Trips never share a customer, so each one can be improved on the pool as soon as it
+        // is built, while construction carries on with the next. Collecting them in order keeps
+        // the result identical to the sequential run.
+        std::unique_ptr<vrp::ThreadPool> pool;
+        if (improveThreads > 0)
+        {
+            pool = std::make_unique<vrp::ThreadPool>(improveThreads);
+        }
+        std::vector<std::future<Route>> improving;
 
         while (visitedCities.size() < cities.size())
         {
@@ -103,32 +267,84 @@ public:
             }
             route.insert(route.begin(), 0);
             route.push_back(0);
-            route = twoOpt(route);
+            if (pool)
+            {
+                improving.push_back(pool->submit([this, route]
+                                                 { return sequenceTrip(route); }));
+                continue;
+            }
+            route = sequenceTrip(route);
             int routeCost = calculateRouteCost(route);
             totalCost += routeCost;
             bestRoutes.push_back(route);
         }
+        for (auto &future : improving)
+        {
+            Route route = future.get();
+            totalCost += calculateRouteCost(route);
+            bestRoutes.push_back(std::move(route));
+        }
 
+        if (guided)
+        {
+            guidedLocalSearch();
+            totalCost = 0;
+            for (const Route &route : bestRoutes)
+            {
+                totalCost += calculateRouteCost(route);
+            }
+        }
         lowerCost = totalCost;
     }
 
+    // Keeps improving the greedy trips past their first local optimum, moving customers between
+    // trips as well, until the guided search budget runs out.
+    void guidedLocalSearch()
+    {
+        if (spatialIndex || hasTimeWindows)
+        {
+            throw std::runtime_error("Guided local search needs a road matrix and no time windows.");
+        }
+        std::vector<int> weights(numberOfCities, 0);
+        for (const auto &city : cities)
+        {
+            weights[city.number] = city.package_weight;
+        }
+        auto cost = [this](int source, int destination)
+        {
+            return legCost(source, destination);
+        };
+        vrp::GuidedLocalSearch<decltype(cost)> search(numberOfCities, weights, vehicleCapacity, maxCitiesPerRoute, cost);
+        search.run(bestRoutes, guidedOptions);
+        guidedIterations = search.iterations;
+        guidedMoves = search.moves;
+        guidedPenalties = search.penalized;
+    }
+
     Route findNextRoute(std::set<int> &visitedCities, int startCity)
     {
+        if (spatialIndex)
+        {
+            return findNextRouteByDistance(visitedCities, startCity);
+        }
+
         Route route;
         int currentCity = startCity;
         int totalWeight = 0;
         int numCitiesVisited = 0;
+        long long departureTime = 0;
 
         while (numCitiesVisited < maxCitiesPerRoute && visitedCities.size() < cities.size())
         {
             int nextCity = -1;
             int minCost = INT_MAX;
 
-            for (const auto &[neighbor, cost] : adjList[currentCity])
+            for (const auto &[neighbor, cost] : neighborsOf(currentCity))
             {
                 if (visitedCities.find(neighbor) == visitedCities.end() &&
                     totalWeight + cities[neighbor].package_weight <= vehicleCapacity &&
-                    cost < minCost)
+                    cost < minCost &&
+                    (!hasTimeWindows || vrp::arrivalTime(timeWindows[neighbor], departureTime, cost) >= 0))
                 {
                     nextCity = neighbor;
                     minCost = cost;
@@ -138,6 +354,10 @@ public:
             if (nextCity == -1)
                 break; // No valid next city found
 
+            if (hasTimeWindows)
+            {
+                departureTime = vrp::arrivalTime(timeWindows[nextCity], departureTime, minCost) + timeWindows[nextCity].service;
+            }
             route.push_back(nextCity);
             visitedCities.insert(nextCity);
             totalWeight += cities[nextCity].package_weight;
@@ -148,45 +368,156 @@ public:
         return route;
     }
 
+    // Same greedy as findNextRoute(), answered by the spatial index instead of an adjacency scan.
+    Route findNextRouteByDistance(std::set<int> &visitedCities, int startCity)
+    {
+        Route route;
+        int currentCity = startCity;
+        int totalWeight = 0;
+
+        while (static_cast<int>(route.size()) < maxCitiesPerRoute)
+        {
+            int nextCity = spatialIndex->nearest(xs[currentCity], ys[currentCity], vehicleCapacity - totalWeight);
+            if (nextCity == -1)
+            {
+                break;
+            }
+
+            route.push_back(nextCity);
+            visitedCities.insert(nextCity);
+            spatialIndex->remove(nextCity);
+            totalWeight += cities[nextCity].package_weight;
+            currentCity = nextCity;
+        }
+
+        return route;
+    }
+
+    // Unlike adjList[city], never inserts, so it is safe while trips are improved on the pool.
+    const std::vector<std::pair<int, int>> &neighborsOf(int city) const
+    {
+        static const std::vector<std::pair<int, int>> none;
+        auto it = adjList.find(city);
+        return it == adjList.end() ? none : it->second;
+    }
+
+    int roadCost(int source, int destination) const
+    {
+        if (spatialIndex)
+        {
+            return vrp::euclideanCost(xs[source], ys[source], xs[destination], ys[destination]);
+        }
+        return roadCosts[static_cast<size_t>(source) * numberOfCities + destination];
+    }
+
     int calculateRouteCost(const Route &route)
     {
         int cost = 0;
         for (size_t i = 0; i < route.size() - 1; ++i)
         {
-            int source = route[i];
-            int destination = route[i + 1];
-            auto it = std::find_if(adjList[source].begin(), adjList[source].end(),
-                                   [destination](const std::pair<int, int> &p)
-                                   { return p.first == destination; });
-            if (it != adjList[source].end())
+            int legCost = roadCost(route[i], route[i + 1]);
+            if (legCost != INT_MAX)
             {
-                cost += it->second;
+                cost += legCost;
             }
         }
         return cost;
     }
 
+    // Trips short enough for the trip cache take the optimal order of their customers. Longer
+    // trips, trips without a complete order and time windows keep 2-opt.
+    Route sequenceTrip(const Route &route)
+    {
+        int count = static_cast<int>(route.size()) - 2;
+        if (tripCache && tripCache->cacheable(count))
+        {
+            vrp::CachedTrip trip = tripCache->trip(&route[1], count, [this](int source, int destination)
+                                                   { return roadCost(source, destination); });
+            if (trip.cost != INT_MAX)
+            {
+                Route ordered{0};
+                ordered.insert(ordered.end(), trip.order.begin(), trip.order.begin() + trip.length);
+                ordered.push_back(0);
+                return ordered;
+            }
+        }
+        return twoOpt(route);
+    }
+
+    // Missing roads cost more than any real route, so moves never introduce them.
+    long long legCost(int source, int destination) const
+    {
+        int cost = roadCost(source, destination);
+        return cost == INT_MAX ? MISSING_ROAD_COST : cost;
+    }
+
+    // Every candidate is priced by its O(1) cost delta. With time windows, prefix and suffix
+    // segments of the current route are cached and the reversed middle grows one city per j,
+    // so the feasibility check is O(1) as well.
     Route twoOpt(const Route &route)
     {
+        if (route.size() >= NEIGHBOR_SEARCH_MIN_LENGTH && symmetricCosts && !hasTimeWindows)
+        {
+            return improveLongRoute(route);
+        }
         Route newRoute = route;
-        int bestCost = calculateRouteCost(route);
         bool improvement = true;
+        std::vector<vrp::TimeWindowSegment> prefixSegments;
+        std::vector<vrp::TimeWindowSegment> suffixSegments;
+        auto travelTime = [this](int source, int destination)
+        {
+            int cost = roadCost(source, destination);
+            return cost == INT_MAX ? vrp::TIME_HORIZON : cost;
+        };
 
         while (improvement)
         {
             improvement = false;
-            for (size_t i = 1; i < route.size() - 2; ++i)
+            if (hasTimeWindows)
+            {
+                buildTimeWindowSegments(newRoute, travelTime, prefixSegments, suffixSegments);
+            }
+
+            for (size_t i = 1; i + 2 < newRoute.size() && !(improvement && hasTimeWindows); ++i)
             {
-                for (size_t j = i + 1; j < route.size() - 1; ++j)
+                long long reversedDelta = 0;
+                vrp::TimeWindowSegment reversed;
+                if (hasTimeWindows)
+                {
+                    reversed = vrp::TimeWindowSegment::single(newRoute[i], timeWindows[newRoute[i]]);
+                }
+
+                for (size_t j = i + 1; j + 1 < newRoute.size(); ++j)
                 {
-                    Route candidate = twoOptSwap(newRoute, i, j);
-                    int candidateCost = calculateRouteCost(candidate);
-                    if (candidateCost < bestCost)
+                    reversedDelta += legCost(newRoute[j], newRoute[j - 1]) - legCost(newRoute[j - 1], newRoute[j]);
+                    long long delta = reversedDelta + legCost(newRoute[i - 1], newRoute[j]) + legCost(newRoute[i], newRoute[j + 1]) -
+                                      legCost(newRoute[i - 1], newRoute[i]) - legCost(newRoute[j], newRoute[j + 1]);
+                    if (hasTimeWindows)
+                    {
+                        reversed = vrp::TimeWindowSegment::join(vrp::TimeWindowSegment::single(newRoute[j], timeWindows[newRoute[j]]), reversed, travelTime);
+                    }
+                    if (delta >= 0)
                     {
-                        newRoute = candidate;
-                        bestCost = candidateCost;
-                        improvement = true;
+                        continue;
                     }
+                    if (hasTimeWindows)
+                    {
+                        auto candidate = vrp::TimeWindowSegment::join(vrp::TimeWindowSegment::join(prefixSegments[i - 1], reversed, travelTime), suffixSegments[j + 1], travelTime);
+                        if (!candidate.feasible())
+                        {
+                            continue;
+                        }
+                    }
+                    newRoute = twoOptSwap(newRoute, i, j);
+                    improvement = true;
+                    if (hasTimeWindows)
+                    {
+                        // The cached segments describe the old route; rebuild them first.
+                        break;
+                    }
+                    // Plain inputs keep scanning the changed route, as this search always has.
+                    // newRoute[i..j] is now the reverse of what reversedDelta was summed over.
+                    reversedDelta = -reversedDelta;
                 }
             }
         }
@@ -194,6 +525,98 @@ public:
         return newRoute;
     }
 
+    // Long trips, from a large maxCitiesPerRoute, are improved by 2-opt and Or-opt restricted to
+    // each city's nearest neighbours within the trip, with don't-look bits (see
+    // vrp-lib/neighbor_list_search.hpp). The depot is one more city of the cyclic tour.
+    Route improveLongRoute(const Route &route)
+    {
+        std::vector<int> tour(route.begin(), route.end() - 1);
+        int length = static_cast<int>(tour.size());
+        std::vector<std::vector<int>> neighbors(length);
+        if (spatialIndex)
+        {
+            std::vector<double> tripXs(length);
+            std::vector<double> tripYs(length);
+            for (int k = 0; k < length; ++k)
+            {
+                tripXs[k] = xs[tour[k]];
+                tripYs[k] = ys[tour[k]];
+            }
+            vrp::SpatialIndex tripIndex(tripXs, tripYs, std::vector<int>(length, 0), 0);
+            for (int k = 0; k < length; ++k)
+            {
+                neighbors[k] = tripIndex.kNearest(k, NEIGHBOR_LIST_SIZE);
+            }
+        }
+        else
+        {
+            // city -> index in this trip, -1 elsewhere; one per thread, as trips may be improved
+            // concurrently.
+            static thread_local std::vector<int> localIndex;
+            localIndex.resize(numberOfCities, -1);
+            for (int k = 0; k < length; ++k)
+            {
+                localIndex[tour[k]] = k;
+            }
+            for (int k = 0; k < length; ++k)
+            {
+                for (const auto &[neighbor, cost] : neighborsOf(tour[k]))
+                {
+                    if (localIndex[neighbor] >= 0 && localIndex[neighbor] != k)
+                    {
+                        neighbors[k].push_back(localIndex[neighbor]);
+                    }
+                }
+                auto byCost = [&](int a, int b)
+                {
+                    return legCost(tour[k], tour[a]) < legCost(tour[k], tour[b]);
+                };
+                size_t kept = std::min<size_t>(NEIGHBOR_LIST_SIZE, neighbors[k].size());
+                std::partial_sort(neighbors[k].begin(), neighbors[k].begin() + kept, neighbors[k].end(), byCost);
+                neighbors[k].resize(kept);
+            }
+            for (int city : tour)
+            {
+                localIndex[city] = -1;
+            }
+        }
+
+        std::vector<int> order(length);
+        for (int k = 0; k < length; ++k)
+        {
+            order[k] = k;
+        }
+        vrp::improveWithNeighborLists(order, neighbors, [&](int a, int b)
+                                      { return legCost(tour[a], tour[b]); });
+        Route improved;
+        improved.reserve(route.size());
+        for (int k : order)
+        {
+            improved.push_back(tour[k]);
+        }
+        improved.push_back(0);
+        return improved;
+    }
+
+    template <typename TravelTime>
+    void buildTimeWindowSegments(const Route &route, TravelTime travelTime, std::vector<vrp::TimeWindowSegment> &prefixSegments,
+                                 std::vector<vrp::TimeWindowSegment> &suffixSegments)
+    {
+        size_t length = route.size();
+        prefixSegments.resize(length);
+        suffixSegments.resize(length);
+        prefixSegments[0] = vrp::TimeWindowSegment::single(route[0], timeWindows[route[0]]);
+        for (size_t k = 1; k < length; ++k)
+        {
+            prefixSegments[k] = vrp::TimeWindowSegment::join(prefixSegments[k - 1], vrp::TimeWindowSegment::single(route[k], timeWindows[route[k]]), travelTime);
+        }
+        suffixSegments[length - 1] = vrp::TimeWindowSegment::single(route[length - 1], timeWindows[route[length - 1]]);
+        for (size_t k = length - 1; k-- > 0;)
+        {
+            suffixSegments[k] = vrp::TimeWindowSegment::join(vrp::TimeWindowSegment::single(route[k], timeWindows[route[k]]), suffixSegments[k + 1], travelTime);
+        }
+    }
+
     Route twoOptSwap(const Route &route, int i, int k)
     {
         Route newRoute(route.begin(), route.begin() + i);
@@ -209,26 +632,117 @@ int main(int argc, char *argv[])
     {
         if (argc < 4)
         {
-            std::cerr << "Usage: " << argv[0] << " <input file> <vehicle capacity> <max cities per route>" << std::endl;
+            std::cerr << "Usage: " << argv[0] << " <input file> <vehicle capacity> <max cities per route> [--shortest-paths] [--output text|json|csv] [--coordinates] [--trip-cache-mb <n>] [--gls-time <ms>] [--gls-iterations <n>] [--improve-threads <n>]" << std::endl;
             return 1;
         }
 
         std::string filename = argv[1];
         int vehicleCapacity = std::stoi(argv[2]);
         int maxCitiesPerRoute = std::stoi(argv[3]);
+        bool shortestPaths = false;
+        vrp::OutputFormat output = vrp::OutputFormat::Text;
+        bool coordinates = false;
+        size_t tripCacheBytes = 0;
+        vrp::GuidedLocalSearchOptions guidedOptions;
+        bool guided = false;
+        unsigned improveThreads = 0;
+        for (int i = 4; i < argc; ++i)
+        {
+            if (std::string(argv[i]) == "--shortest-paths")
+            {
+                shortestPaths = true;
+            }
+            else if (std::string(argv[i]) == "--output" && i + 1 < argc)
+            {
+                output = vrp::parseOutputFormat(argv[++i]);
+            }
+            else if (std::string(argv[i]) == "--coordinates")
+            {
+                coordinates = true;
+            }
+            else if (std::string(argv[i]) == "--trip-cache-mb" && i + 1 < argc)
+            {
+                tripCacheBytes = static_cast<size_t>(std::stoul(argv[++i])) << 20;
+            }
+            else if (std::string(argv[i]) == "--gls-time" && i + 1 < argc)
+            {
+                guided = true;
+                guidedOptions.timeLimitMillis = std::stod(argv[++i]);
+            }
+            else if (std::string(argv[i]) == "--gls-iterations" && i + 1 < argc)
+            {
+                guided = true;
+                guidedOptions.maxIterations = std::stoll(argv[++i]);
+            }
+            else if (std::string(argv[i]) == "--improve-threads" && i + 1 < argc)
+            {
+                improveThreads = static_cast<unsigned>(std::stoul(argv[++i]));
+            }
+        }
 
-        VRPSolver solver(filename, vehicleCapacity, maxCitiesPerRoute);
+        auto loadStart = std::chrono::high_resolution_clock::now();
+        VRPSolver solver(filename, vehicleCapacity, maxCitiesPerRoute, coordinates);
+        solver.tripCacheBytes = tripCacheBytes;
+        solver.guided = guided;
+        solver.guidedOptions = guidedOptions;
+        solver.improveThreads = improveThreads;
+        double loadMillis = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - loadStart).count();
+        double pathsMillis = 0;
+        if (shortestPaths)
+        {
+            auto pathsStart = std::chrono::high_resolution_clock::now();
+            solver.useShortestPaths();
+            auto pathsTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - pathsStart);
+            pathsMillis = pathsTime.count() / 1000.0;
+            if (output == vrp::OutputFormat::Text)
+            {
+                std::cout << "Shortest paths (" << (solver.usedFloydWarshall() ? "Floyd-Warshall" : "Dijkstra") << "): " << pathsTime.count() << " microseconds" << std::endl;
+            }
+        }
 
         auto startTime = std::chrono::high_resolution_clock::now();
         solver.solve();
         auto endTime = std::chrono::high_resolution_clock::now();
 
+        if (output != vrp::OutputFormat::Text)
+        {
+            vrp::RunResult result;
+            result.engine = "local-search";
+            result.instance = filename;
+            result.cities = solver.customers();
+            result.roads = solver.roadCount();
+            result.vehicleCapacity = vehicleCapacity;
+            result.maxCitiesPerRoute = maxCitiesPerRoute;
+            result.cost = solver.lowerCost;
+            for (const Route &route : solver.bestRoutes)
+            {
+                result.routes.push_back(solver.expandedRoute(route));
+            }
+            result.timingsMillis = {{"load", loadMillis}, {"shortestPaths", pathsMillis}, {"solve", std::chrono::duration<double, std::milli>(endTime - startTime).count()}};
+            result.counters = {{"trips", static_cast<long long>(solver.bestRoutes.size())}};
+            if (solver.guided)
+            {
+                result.counters.push_back({"glsIterations", solver.guidedIterations});
+                result.counters.push_back({"glsMoves", solver.guidedMoves});
+                result.counters.push_back({"glsPenalties", solver.guidedPenalties});
+            }
+            if (solver.tripCache)
+            {
+                result.counters.push_back({"tripCacheHits", solver.tripCache->hits()});
+                result.counters.push_back({"tripCacheMisses", solver.tripCache->misses()});
+                result.counters.push_back({"tripCacheEvictions", solver.tripCache->evictions()});
+                result.counters.push_back({"tripCacheBytes", static_cast<long long>(solver.tripCache->memoryBytes())});
+            }
+            vrp::writeResult(result, output);
+            return 0;
+        }
+
         std::cout << "Lower cost: " << solver.lowerCost << std::endl;
 
         int routesLength = solver.bestRoutes.size();
         for (const Route &route : solver.bestRoutes)
         {
-            for (int city : route)
+            for (int city : solver.expandedRoute(route))
             {
                 std::cout << city << " ";
             }
@@ -241,6 +755,19 @@ int main(int argc, char *argv[])
         auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
 
         std::cout << "Time taken: " << duration << " nanosseconds" << std::endl;
+        if (solver.guided)
+        {
+            std::cout << "Guided local search: " << solver.guidedIterations << " iterations, " << solver.guidedMoves << " moves, "
+                      << solver.guidedPenalties << " penalties" << std::endl;
+        }
+        if (solver.tripCache)
+        {
+            const vrp::TripCache &cache = *solver.tripCache;
+            long long lookups = cache.hits() + cache.misses();
+            std::cout << "Trip cache: " << cache.hits() << " hits, " << cache.misses() << " misses ("
+                      << (lookups > 0 ? 100 * cache.hits() / lookups : 0) << "% hit rate), " << cache.evictions() << " evictions, "
+                      << cache.memoryBytes() / 1024 << " KB" << std::endl;
+        }
     }
     catch (const std::exception &e)
     {
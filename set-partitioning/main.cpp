@@ -0,0 +1,426 @@
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <exception>
+#include <unordered_map>
+#include <chrono>
+#include <climits>
+
+#include "../vrp-lib/guided_local_search.hpp"
+#include "../vrp-lib/result_writer.hpp"
+#include "../vrp-lib/set_partitioning.hpp"
+#include "../vrp-lib/shortest_paths.hpp"
+
+using Route = std::vector<int>;
+
+// Penalty rounds of the guided local search that seeds the incumbent; --seed-iterations 0 skips it.
+constexpr long long DEFAULT_SEED_ITERATIONS = 5000;
+
+struct RouteHash
+{
+    size_t operator()(const Route &route) const
+    {
+        size_t hash = route.size();
+        for (int city : route)
+        {
+            hash ^= static_cast<size_t>(city) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+        }
+        return hash;
+    }
+};
+
+// A partial trip from the depot: the customers in visiting order, their load and the cost so far.
+struct Label
+{
+    Route path;
+    int load;
+    long long cost;
+};
+
+// Exact solver that splits the problem in two. A labeling algorithm enumerates every feasible
+// trip and keeps, for each set of customers, only its cheapest visiting order; then a
+// set-partitioning model picks the cheapest trips covering every customer exactly once. A guided
+// local search gives the model its first incumbent.
+class VRPSolver
+{
+private:
+    static constexpr size_t MAX_LABELS = 50000000;
+    static constexpr long long MISSING_ROAD_COST = 1000000000;
+
+    vrp::Instance instance;
+    int numberOfCities; // depot included
+    std::vector<int> roadCosts; // numberOfCities x numberOfCities, INT_MAX where there is no road
+    vrp::ShortestPaths shortestPaths;
+    bool shortestPathsEnabled = false;
+    std::vector<vrp::Column> columns;
+    std::vector<Route> trips; // visiting order of every column
+    std::unordered_map<Route, size_t, RouteHash> columnOfSet; // sorted customers -> column
+
+public:
+    int vehicleCapacity;
+    int maxCitiesPerRoute;
+    long long lowerCost = LLONG_MAX;
+    Route bestRoute;
+    size_t labels = 0;
+    size_t dominated = 0;
+    long long nodes = 0;
+    long long pivots = 0;
+    vrp::SetPartitioningLimits limits;
+    vrp::GuidedLocalSearchOptions seedOptions;
+    long long seedCost = LLONG_MAX; // of the guided search solution, if it was offered
+    long long lowerBound = 0;
+    bool optimal = false;
+
+    VRPSolver(const std::string &filename, int vehicleCapacity, int maxCitiesPerRoute)
+        : instance(vrp::readInstance(filename, vehicleCapacity, maxCitiesPerRoute)), numberOfCities(instance.numberOfCustomers + 1),
+          vehicleCapacity(vehicleCapacity), maxCitiesPerRoute(maxCitiesPerRoute)
+    {
+        roadCosts.assign(static_cast<size_t>(numberOfCities) * numberOfCities, INT_MAX);
+        for (const vrp::Edge &road : instance.roads)
+        {
+            if (road.start < 0 || road.start >= numberOfCities || road.destination < 0 || road.destination >= numberOfCities)
+            {
+                throw std::runtime_error("Road references an unknown city.");
+            }
+            int &cost = roadCosts[static_cast<size_t>(road.start) * numberOfCities + road.destination];
+            cost = std::min(cost, road.cost);
+        }
+    }
+
+    int customers() const
+    {
+        return instance.numberOfCustomers;
+    }
+
+    size_t roadCount() const
+    {
+        return instance.roads.size();
+    }
+
+    size_t columnCount() const
+    {
+        return columns.size();
+    }
+
+    // Replaces direct roads by shortest paths, so a trip may pass through other cities on its way.
+    void useShortestPaths()
+    {
+        shortestPaths.compute(numberOfCities, instance.roads);
+        roadCosts = shortestPaths.matrix();
+        shortestPathsEnabled = true;
+    }
+
+    bool usedFloydWarshall() const
+    {
+        return shortestPaths.usedFloydWarshall();
+    }
+
+    // The route with every leg expanded into the roads it actually drives on.
+    Route expandedRoute(const Route &route) const
+    {
+        return shortestPathsEnabled ? shortestPaths.expand(route) : route;
+    }
+
+    void solve()
+    {
+        enumerateTrips();
+
+        vrp::SetPartitioningSolver partitioning(instance.numberOfCustomers, columns);
+        std::vector<int> seed = guidedSeed();
+        if (!seed.empty() && partitioning.offerIncumbent(seed))
+        {
+            seedCost = 0;
+            for (int column : seed)
+            {
+                seedCost += columns[column].cost;
+            }
+        }
+        lowerCost = partitioning.solve(limits);
+        nodes = partitioning.nodes;
+        pivots = partitioning.pivots;
+        lowerBound = partitioning.lowerBound;
+        optimal = partitioning.optimal;
+        if (lowerCost == LLONG_MAX)
+        {
+            throw std::runtime_error(optimal ? "No combination of feasible trips visits every city exactly once." : "No solution found within the limits.");
+        }
+
+        std::vector<int> chosen = partitioning.solution();
+        std::sort(chosen.begin(), chosen.end(), [this](int a, int b)
+                  { return columns[a].rows.front() < columns[b].rows.front(); });
+        bestRoute.assign(1, 0);
+        for (int column : chosen)
+        {
+            bestRoute.insert(bestRoute.end(), trips[column].begin(), trips[column].end());
+            bestRoute.push_back(0);
+        }
+    }
+
+private:
+    int cost(int from, int to) const
+    {
+        return roadCosts[static_cast<size_t>(from) * numberOfCities + to];
+    }
+
+    // Columns of a guided local search solution started from one trip per customer, or nothing
+    // when some customer has no trip of its own or a trip of the result is not in the pool.
+    std::vector<int> guidedSeed()
+    {
+        if (seedOptions.timeLimitMillis <= 0 && seedOptions.maxIterations <= 0)
+        {
+            return {};
+        }
+        std::vector<Route> solution;
+        for (int city = 1; city < numberOfCities; ++city)
+        {
+            if (columnOfSet.find({city}) == columnOfSet.end())
+            {
+                return {};
+            }
+            solution.push_back({0, city, 0});
+        }
+        auto legCost = [this](int source, int destination)
+        {
+            int road = cost(source, destination);
+            return road == INT_MAX ? MISSING_ROAD_COST : static_cast<long long>(road);
+        };
+        vrp::GuidedLocalSearch<decltype(legCost)> search(numberOfCities, instance.packageWeights, vehicleCapacity, maxCitiesPerRoute, legCost);
+        search.run(solution, seedOptions);
+
+        std::vector<int> seed;
+        Route key;
+        for (const Route &trip : solution)
+        {
+            key.assign(trip.begin() + 1, trip.end() - 1);
+            std::sort(key.begin(), key.end());
+            auto entry = columnOfSet.find(key);
+            if (entry == columnOfSet.end())
+            {
+                return {};
+            }
+            seed.push_back(static_cast<int>(entry->second));
+        }
+        return seed;
+    }
+
+    // Extends labels one customer at a time. Two labels over the same customers that end at the
+    // same city have the same load and the same possible extensions, so only the cheaper one is
+    // kept. Every label that can drive back to the depot closes a trip, and each customer set
+    // becomes one column priced at its cheapest closed trip.
+    void enumerateTrips()
+    {
+        std::vector<Label> level;
+        for (int city = 1; city < numberOfCities && maxCitiesPerRoute > 0; ++city)
+        {
+            if (cost(0, city) != INT_MAX && instance.packageWeights[city] <= vehicleCapacity)
+            {
+                level.push_back({{city}, instance.packageWeights[city], cost(0, city)});
+            }
+        }
+
+        Route key;
+        while (!level.empty())
+        {
+            labels += level.size();
+            if (labels > MAX_LABELS)
+            {
+                throw std::runtime_error("Trip enumeration exceeded " + std::to_string(MAX_LABELS) + " labels; lower the max cities per route.");
+            }
+
+            for (const Label &label : level)
+            {
+                int back = cost(label.path.back(), 0);
+                if (back == INT_MAX)
+                {
+                    continue;
+                }
+                key = label.path;
+                std::sort(key.begin(), key.end());
+                auto [entry, inserted] = columnOfSet.try_emplace(key, columns.size());
+                if (inserted)
+                {
+                    vrp::Column column;
+                    for (int city : key)
+                    {
+                        column.rows.push_back(city - 1);
+                    }
+                    column.cost = label.cost + back;
+                    columns.push_back(std::move(column));
+                    trips.push_back(label.path);
+                }
+                else if (label.cost + back < columns[entry->second].cost)
+                {
+                    columns[entry->second].cost = label.cost + back;
+                    trips[entry->second] = label.path;
+                }
+            }
+            if (static_cast<int>(level.front().path.size()) == maxCitiesPerRoute)
+            {
+                break;
+            }
+
+            std::unordered_map<Route, size_t, RouteHash> labelOf;
+            std::vector<Label> next;
+            for (const Label &label : level)
+            {
+                int last = label.path.back();
+                for (int city = 1; city < numberOfCities; ++city)
+                {
+                    int arc = cost(last, city);
+                    if (arc == INT_MAX || label.load + instance.packageWeights[city] > vehicleCapacity ||
+                        std::find(label.path.begin(), label.path.end(), city) != label.path.end())
+                    {
+                        continue;
+                    }
+                    key = label.path;
+                    std::sort(key.begin(), key.end());
+                    key.insert(std::upper_bound(key.begin(), key.end(), city), city);
+                    key.push_back(city);
+                    auto [entry, inserted] = labelOf.try_emplace(key, next.size());
+                    if (inserted)
+                    {
+                        next.push_back({label.path, label.load + instance.packageWeights[city], label.cost + arc});
+                        next.back().path.push_back(city);
+                    }
+                    else
+                    {
+                        ++dominated;
+                        Label &incumbent = next[entry->second];
+                        if (label.cost + arc < incumbent.cost)
+                        {
+                            incumbent.cost = label.cost + arc;
+                            incumbent.path.assign(label.path.begin(), label.path.end());
+                            incumbent.path.push_back(city);
+                        }
+                    }
+                }
+            }
+            level = std::move(next);
+        }
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        if (argc < 4)
+        {
+            std::cerr << "Usage: " << argv[0] << " <input file> <vehicle capacity> <max cities per route> [--shortest-paths] [--output text|json|csv] [--time-limit <ms>] [--node-limit <n>] [--seed-iterations <n>]" << std::endl;
+            return 1;
+        }
+
+        std::string filename = argv[1];
+        int vehicleCapacity = std::stoi(argv[2]);
+        int maxCitiesPerRoute = std::stoi(argv[3]);
+        bool shortestPaths = false;
+        vrp::OutputFormat output = vrp::OutputFormat::Text;
+        vrp::SetPartitioningLimits limits;
+        vrp::GuidedLocalSearchOptions seedOptions;
+        seedOptions.maxIterations = DEFAULT_SEED_ITERATIONS;
+        for (int i = 4; i < argc; ++i)
+        {
+            if (std::string(argv[i]) == "--shortest-paths")
+            {
+                shortestPaths = true;
+            }
+            else if (std::string(argv[i]) == "--output" && i + 1 < argc)
+            {
+                output = vrp::parseOutputFormat(argv[++i]);
+            }
+            else if (std::string(argv[i]) == "--time-limit" && i + 1 < argc)
+            {
+                limits.timeLimitMillis = std::stod(argv[++i]);
+            }
+            else if (std::string(argv[i]) == "--node-limit" && i + 1 < argc)
+            {
+                limits.nodeLimit = std::stoll(argv[++i]);
+            }
+            else if (std::string(argv[i]) == "--seed-iterations" && i + 1 < argc)
+            {
+                seedOptions.maxIterations = std::stoll(argv[++i]);
+            }
+        }
+
+        auto loadStart = std::chrono::high_resolution_clock::now();
+        VRPSolver solver(filename, vehicleCapacity, maxCitiesPerRoute);
+        solver.limits = limits;
+        solver.seedOptions = seedOptions;
+        double loadMillis = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - loadStart).count();
+        if (output == vrp::OutputFormat::Text)
+        {
+            std::cout << "Starting solver for " << solver.customers() << " cities and " << solver.roadCount() << " routes..." << std::endl;
+        }
+        double pathsMillis = 0;
+        if (shortestPaths)
+        {
+            auto pathsStart = std::chrono::high_resolution_clock::now();
+            solver.useShortestPaths();
+            auto pathsTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - pathsStart);
+            pathsMillis = pathsTime.count() / 1000.0;
+            if (output == vrp::OutputFormat::Text)
+            {
+                std::cout << "Shortest paths (" << (solver.usedFloydWarshall() ? "Floyd-Warshall" : "Dijkstra") << "): " << pathsTime.count() << " microseconds" << std::endl;
+            }
+        }
+
+        auto startTime = std::chrono::high_resolution_clock::now();
+        solver.solve();
+        auto endTime = std::chrono::high_resolution_clock::now();
+
+        if (output != vrp::OutputFormat::Text)
+        {
+            vrp::RunResult result;
+            result.engine = "set-partitioning";
+            result.instance = filename;
+            result.cities = solver.customers();
+            result.roads = solver.roadCount();
+            result.vehicleCapacity = vehicleCapacity;
+            result.maxCitiesPerRoute = maxCitiesPerRoute;
+            result.cost = solver.lowerCost;
+            result.routes = vrp::splitTrips(solver.expandedRoute(solver.bestRoute));
+            result.timingsMillis = {{"load", loadMillis}, {"shortestPaths", pathsMillis}, {"solve", std::chrono::duration<double, std::milli>(endTime - startTime).count()}};
+            result.counters = {{"labels", static_cast<long long>(solver.labels)}, {"dominatedLabels", static_cast<long long>(solver.dominated)},
+                               {"columns", static_cast<long long>(solver.columnCount())}, {"branchAndBoundNodes", solver.nodes}, {"simplexPivots", solver.pivots},
+                               {"lowerBound", solver.lowerBound}, {"optimal", solver.optimal ? 1 : 0}};
+            if (solver.seedCost != LLONG_MAX)
+            {
+                result.counters.push_back({"seedCost", solver.seedCost});
+            }
+            vrp::writeResult(result, output);
+            return 0;
+        }
+
+        std::cout << "Trips: " << solver.columnCount() << " columns from " << solver.labels << " labels (" << solver.dominated << " dominated)" << std::endl;
+        std::cout << "Lower cost: " << solver.lowerCost << std::endl;
+
+        Route bestRoute = solver.expandedRoute(solver.bestRoute);
+        for (size_t i = 0; i < bestRoute.size(); ++i)
+        {
+            std::cout << bestRoute[i] << (i + 1 < bestRoute.size() ? " -> " : "");
+        }
+        std::cout << std::endl;
+        std::cout << "Branch and bound: " << solver.nodes << " nodes, " << solver.pivots << " simplex pivots" << std::endl;
+        if (solver.seedCost != LLONG_MAX)
+        {
+            std::cout << "Guided local search seed: " << solver.seedCost << std::endl;
+        }
+        if (solver.optimal)
+        {
+            std::cout << "Optimal" << std::endl;
+        }
+        else
+        {
+            double gap = solver.lowerCost > 0 ? 100.0 * (solver.lowerCost - solver.lowerBound) / solver.lowerCost : 0;
+            std::cout << "Stopped at a limit: lower bound " << solver.lowerBound << ", gap " << gap << "%" << std::endl;
+        }
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
+        std::cout << "Time taken: " << duration.count() << " milliseconds" << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,248 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <exception>
+
+#include "../vrp-lib/vrp_solver.hpp"
+
+// Checks a solution printed by any of the engines against its graph. Roads are kept in CSR
+// form with every row sorted by destination, so each leg is one binary search and the whole
+// check is a single pass over the route.
+class SolutionVerifier
+{
+private:
+    static constexpr int MAX_REPORTED = 20;
+
+    int numberOfCities; // depot included
+    std::vector<int> weights;
+    std::vector<size_t> offsets;
+    std::vector<std::pair<int, int>> adjacency; // (destination, cost), cheapest road first
+    int vehicleCapacity;
+    int maxCitiesPerRoute;
+    std::vector<std::string> errors;
+    size_t errorCount = 0;
+
+public:
+    long long claimedCost = -1;
+    std::vector<int> sequence;
+    long long computedCost = 0;
+    int trips = 0;
+
+    SolutionVerifier(const vrp::Instance &instance, int vehicleCapacity, int maxCitiesPerRoute)
+        : numberOfCities(instance.numberOfCustomers + 1), weights(instance.packageWeights),
+          vehicleCapacity(vehicleCapacity), maxCitiesPerRoute(maxCitiesPerRoute)
+    {
+        offsets.assign(numberOfCities + 1, 0);
+        for (const vrp::Edge &road : instance.roads)
+        {
+            if (road.start < 0 || road.start >= numberOfCities || road.destination < 0 || road.destination >= numberOfCities)
+            {
+                throw std::runtime_error("Road references an unknown city.");
+            }
+            offsets[road.start + 1]++;
+        }
+        for (int city = 0; city < numberOfCities; ++city)
+        {
+            offsets[city + 1] += offsets[city];
+        }
+        adjacency.resize(instance.roads.size());
+        std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+        for (const vrp::Edge &road : instance.roads)
+        {
+            adjacency[fill[road.start]++] = {road.destination, road.cost};
+        }
+        for (int city = 0; city < numberOfCities; ++city)
+        {
+            std::sort(adjacency.begin() + offsets[city], adjacency.begin() + offsets[city + 1]);
+        }
+    }
+
+    // Reads engine output: the "Lower cost: N" line followed by the route line, written either
+    // as "0 -> 1 -> 0 -> 2 -> 0" or as trips "0 1 0 -> 0 2 0". Other lines are ignored.
+    void readSolution(const std::string &filename)
+    {
+        std::ifstream file(filename);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Failed to open solution file.");
+        }
+        std::string line;
+        bool expectRoute = false;
+        while (std::getline(file, line))
+        {
+            if (line.rfind("Lower cost:", 0) == 0)
+            {
+                claimedCost = std::stoll(line.substr(11));
+                expectRoute = true;
+            }
+            else if (expectRoute)
+            {
+                std::replace(line.begin(), line.end(), '-', ' ');
+                std::replace(line.begin(), line.end(), '>', ' ');
+                std::istringstream cities(line);
+                int city;
+                while (cities >> city)
+                {
+                    sequence.push_back(city);
+                }
+                break;
+            }
+        }
+        if (claimedCost < 0)
+        {
+            throw std::runtime_error("No \"Lower cost:\" line in " + filename + ".");
+        }
+    }
+
+    // Returns true when the solution is feasible and its cost matches the claim.
+    bool verify()
+    {
+        std::vector<char> visited(numberOfCities, 0);
+        int load = 0;
+        int stops = 0;
+        bool inTrip = false;
+        if (sequence.empty() || sequence.front() != 0 || sequence.back() != 0)
+        {
+            report("the routes must start and end at the depot");
+        }
+
+        for (size_t i = 0; i < sequence.size(); ++i)
+        {
+            int city = sequence[i];
+            if (city < 0 || city >= numberOfCities)
+            {
+                report("unknown city " + std::to_string(city));
+                continue;
+            }
+            if (i > 0 && !(sequence[i - 1] == 0 && city == 0))
+            {
+                int cost = roadCost(sequence[i - 1], city);
+                if (cost < 0)
+                {
+                    report("no road " + std::to_string(sequence[i - 1]) + " -> " + std::to_string(city));
+                }
+                else
+                {
+                    computedCost += cost;
+                }
+            }
+            if (city == 0)
+            {
+                if (inTrip)
+                {
+                    closeTrip(load, stops);
+                }
+                inTrip = false;
+                load = 0;
+                stops = 0;
+                continue;
+            }
+            inTrip = true;
+            if (visited[city])
+            {
+                report("city " + std::to_string(city) + " is visited more than once");
+            }
+            visited[city] = 1;
+            load += weights[city];
+            stops++;
+        }
+
+        for (int city = 1; city < numberOfCities; ++city)
+        {
+            if (!visited[city])
+            {
+                report("city " + std::to_string(city) + " is never visited");
+            }
+        }
+        if (computedCost != claimedCost)
+        {
+            report("claimed cost " + std::to_string(claimedCost) + " but the routes cost " + std::to_string(computedCost));
+        }
+        return errorCount == 0;
+    }
+
+    void printErrors(std::ostream &out) const
+    {
+        for (const auto &error : errors)
+        {
+            out << "  " << error << '\n';
+        }
+        if (errorCount > errors.size())
+        {
+            out << "  ... and " << errorCount - errors.size() << " more" << '\n';
+        }
+    }
+
+private:
+    // Cheapest road from source to destination, or -1.
+    int roadCost(int source, int destination) const
+    {
+        auto first = adjacency.begin() + offsets[source];
+        auto last = adjacency.begin() + offsets[source + 1];
+        auto road = std::lower_bound(first, last, std::make_pair(destination, INT_MIN));
+        return road != last && road->first == destination ? road->second : -1;
+    }
+
+    void closeTrip(int load, int stops)
+    {
+        trips++;
+        if (load > vehicleCapacity)
+        {
+            report("trip " + std::to_string(trips) + " carries " + std::to_string(load) + " over capacity " + std::to_string(vehicleCapacity));
+        }
+        if (stops > maxCitiesPerRoute)
+        {
+            report("trip " + std::to_string(trips) + " makes " + std::to_string(stops) + " stops, limit " + std::to_string(maxCitiesPerRoute));
+        }
+    }
+
+    void report(const std::string &error)
+    {
+        if (errors.size() < MAX_REPORTED)
+        {
+            errors.push_back(error);
+        }
+        errorCount++;
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        if (argc < 5)
+        {
+            std::cerr << "Usage: " << argv[0] << " <input file> <solution file> <vehicle capacity> <max cities per route>" << std::endl;
+            return 2;
+        }
+
+        int vehicleCapacity = std::stoi(argv[3]);
+        int maxCitiesPerRoute = std::stoi(argv[4]);
+
+        auto startTime = std::chrono::high_resolution_clock::now();
+        vrp::Instance instance = vrp::readInstance(argv[1], vehicleCapacity, maxCitiesPerRoute);
+        SolutionVerifier verifier(instance, vehicleCapacity, maxCitiesPerRoute);
+        verifier.readSolution(argv[2]);
+        bool valid = verifier.verify();
+        auto endTime = std::chrono::high_resolution_clock::now();
+
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
+        if (valid)
+        {
+            std::cout << "Valid: " << verifier.trips << " trips, cost " << verifier.computedCost << " (" << duration.count() << " milliseconds)" << std::endl;
+            return 0;
+        }
+        std::cout << "Invalid solution:" << std::endl;
+        verifier.printErrors(std::cout);
+        return 1;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 2;
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <iostream>
+
+// Minimal assertions for the test programs: a failed CHECK prints its location and the test
+// exits with status 1 at the end of main() through CHECK_RESULT().
+
+inline int &checkFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition)                                                                          \
+    do                                                                                            \
+    {                                                                                             \
+        if (!(condition))                                                                         \
+        {                                                                                         \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed" << std::endl; \
+            ++checkFailures();                                                                    \
+        }                                                                                         \
+    } while (0)
+
+#define CHECK_RESULT() (checkFailures() == 0 ? 0 : 1)
@@ -0,0 +1,69 @@
+#include "../vrp-lib/vrp_solver.hpp"
+#include "check.hpp"
+
+static vrp::Instance smallInstance()
+{
+    vrp::Instance instance;
+    instance.numberOfCustomers = 5;
+    instance.packageWeights = {0, 6, 4, 7, 3, 5};
+    instance.vehicleCapacity = 12;
+    instance.maxCitiesPerRoute = 3;
+    for (int from = 0; from <= 5; ++from)
+    {
+        for (int to = 0; to <= 5; ++to)
+        {
+            if (from != to)
+            {
+                instance.roads.push_back({from, to, 10 + 7 * ((from * 3 + to * 5) % 11)});
+            }
+        }
+    }
+    return instance;
+}
+
+static long long drivenCost(const vrp::Instance &instance, const std::vector<vrp::Route> &routes)
+{
+    long long total = 0;
+    for (const vrp::Route &route : routes)
+    {
+        for (size_t i = 0; i + 1 < route.size(); ++i)
+        {
+            for (const vrp::Edge &road : instance.roads)
+            {
+                if (road.start == route[i] && road.destination == route[i + 1])
+                {
+                    total += road.cost;
+                }
+            }
+        }
+    }
+    return total;
+}
+
+// One vehicle type with a rate other than 1 is still the single-type case; both engines must
+// charge the rate.
+static void testSingleTypeRate()
+{
+    vrp::Instance instance = smallInstance();
+    vrp::VRPSolver plain(instance);
+    vrp::Solution plainLocal = plain.solve(vrp::Engine::Local);
+    vrp::Solution plainGlobal = plain.solve(vrp::Engine::Global);
+
+    instance.fleet = {vrp::VehicleType{12, 3, 2, vrp::VehicleType::UNLIMITED}};
+    vrp::VRPSolver solver(instance);
+    vrp::Solution local = solver.solve(vrp::Engine::Local);
+    vrp::Solution global = solver.solve(vrp::Engine::Global);
+
+    CHECK(local.feasible && global.feasible);
+    CHECK(local.cost == 2 * drivenCost(instance, local.routes));
+    CHECK(global.cost == 2 * drivenCost(instance, global.routes));
+    CHECK(local.cost == 2 * plainLocal.cost);
+    CHECK(global.cost == 2 * plainGlobal.cost);
+    CHECK(global.cost <= local.cost);
+}
+
+int main()
+{
+    testSingleTypeRate();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,58 @@
+#include <vector>
+
+#include "../vrp-lib/guided_local_search.hpp"
+#include "check.hpp"
+
+// Customers 1 and 2 are close to the depot but far from each other, 3 and 4 are close to
+// each other. With two stops per trip, the greedy trips 0 1 2 0 and 0 3 4 0 are
+// both full, and the optimum splits 1 and 2 into trips of their own.
+static long long roadCost(int source, int destination)
+{
+    if (source == 0 || destination == 0)
+    {
+        return 10;
+    }
+    if (source >= 3 && destination >= 3)
+    {
+        return 1;
+    }
+    return 100;
+}
+
+static long long totalCost(const std::vector<std::vector<int>> &trips)
+{
+    long long total = 0;
+    for (const std::vector<int> &trip : trips)
+    {
+        for (size_t k = 1; k < trip.size(); ++k)
+        {
+            total += roadCost(trip[k - 1], trip[k]);
+        }
+    }
+    return total;
+}
+
+// Relocation into the spare empty trip is the only way to the optimum.
+static void testOpensNewTrip()
+{
+    std::vector<int> weights{0, 1, 1, 1, 1};
+    std::vector<std::vector<int>> trips{{0, 1, 2, 0}, {0, 3, 4, 0}};
+    vrp::GuidedLocalSearch<long long (*)(int, int)> search(5, weights, 10, 2, roadCost);
+    vrp::GuidedLocalSearchOptions options;
+    options.maxIterations = 5;
+    search.run(trips, options);
+
+    CHECK(trips.size() == 3);
+    CHECK(search.bestCost == 61);
+    CHECK(totalCost(trips) == search.bestCost);
+    for (const std::vector<int> &trip : trips)
+    {
+        CHECK(trip.size() > 2);
+    }
+}
+
+int main()
+{
+    testOpensNewTrip();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,87 @@
+#include <numeric>
+
+#include "../vrp-lib/incremental_solver.hpp"
+#include "check.hpp"
+
+// The depot is 100 away from every customer and customers are 1 apart, so every city wants to
+// share one trip as long as the capacity allows it.
+static vrp::Instance clusteredInstance(std::vector<int> weights)
+{
+    vrp::Instance instance;
+    instance.numberOfCustomers = weights.size();
+    instance.packageWeights = {0};
+    instance.packageWeights.insert(instance.packageWeights.end(), weights.begin(), weights.end());
+    instance.vehicleCapacity = 10;
+    instance.maxCitiesPerRoute = 3;
+    for (int from = 0; from <= instance.numberOfCustomers; ++from)
+    {
+        for (int to = 0; to <= instance.numberOfCustomers; ++to)
+        {
+            if (from != to)
+            {
+                instance.roads.push_back({from, to, from == 0 || to == 0 ? 100 : 1});
+            }
+        }
+    }
+    return instance;
+}
+
+static void checkLoads(const vrp::IncrementalSolver &solver, const std::vector<int> &weights)
+{
+    const std::vector<vrp::Route> &routes = solver.currentRoutes();
+    CHECK(solver.currentLoads().size() == routes.size());
+    for (size_t route = 0; route < routes.size(); ++route)
+    {
+        int load = 0;
+        for (size_t i = 1; i + 1 < routes[route].size(); ++i)
+        {
+            load += weights[routes[route][i]];
+        }
+        CHECK(solver.currentLoads()[route] == load);
+    }
+}
+
+// A weight update that overflows the trip moves the city out; the trip it left must keep the
+// load of the cities still on it, so a lighter city can be relocated back into it.
+static void testWeightUpdateKeepsLoads()
+{
+    std::vector<int> weights{0, 4, 4};
+    vrp::IncrementalSolver solver(clusteredInstance({4, 4}));
+    vrp::Solution solution = solver.solve();
+    CHECK(solution.routes.size() == 1);
+    checkLoads(solver, weights);
+
+    weights[1] = 9;
+    solver.updateWeight(1, 9);
+    solution = solver.reoptimize();
+    CHECK(solution.routes.size() == 2);
+    checkLoads(solver, weights);
+
+    weights[1] = 5;
+    solver.updateWeight(1, 5);
+    solution = solver.reoptimize();
+    CHECK(solution.routes.size() == 1);
+    CHECK(solution.cost == 201);
+    checkLoads(solver, weights);
+}
+
+// A city whose demand no longer fits in a vehicle makes the solution infeasible, and a later
+// update that fits again makes it feasible.
+static void testOverweightCityIsInfeasible()
+{
+    vrp::IncrementalSolver solver(clusteredInstance({4, 4}));
+    CHECK(solver.solve().feasible);
+
+    solver.updateWeight(1, 11);
+    CHECK(!solver.reoptimize().feasible);
+
+    solver.updateWeight(1, 6);
+    CHECK(solver.reoptimize().feasible);
+}
+
+int main()
+{
+    testWeightUpdateKeepsLoads();
+    testOverweightCityIsInfeasible();
+    return CHECK_RESULT();
+}
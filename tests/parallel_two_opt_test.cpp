@@ -0,0 +1,65 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include <omp.h>
+
+#include "../vrp-lib/parallel_two_opt.hpp"
+#include "check.hpp"
+
+// Cities lie on a line at their own number, so the cost of a road is the distance between them.
+static long long lineCost(int from, int to)
+{
+    return std::abs(from - to);
+}
+
+// A depot-to-depot trip over cities first..first + count - 1 in a scrambled order.
+static std::vector<int> scrambledTrip(int first, int count)
+{
+    std::vector<int> trip{0};
+    for (int k = 0; k < count; ++k)
+    {
+        trip.push_back(first + (k * 7919) % count);
+    }
+    trip.push_back(0);
+    return trip;
+}
+
+// A trip of at least PARALLEL_TWO_OPT_MIN_LENGTH cities is scanned by every thread, the short
+// ones are not, and each trip ends as it would after a serial 2-opt.
+static void testLongTripsUseAllThreads()
+{
+    omp_set_num_threads(4);
+    std::vector<std::vector<int>> trips{scrambledTrip(1, 5), scrambledTrip(6, 300), scrambledTrip(306, 7)};
+    std::vector<std::vector<int>> expected = trips;
+    for (std::vector<int> &trip : expected)
+    {
+        vrp::twoOptBestImprovement(trip, lineCost, SIZE_MAX);
+    }
+
+    std::atomic<int> longTripThreads{0};
+    auto cost = [&](int from, int to)
+    {
+        if (from > 5 && from < 306 && to > 5 && to < 306)
+        {
+            int threads = omp_get_num_threads();
+            int seen = longTripThreads.load();
+            while (threads > seen && !longTripThreads.compare_exchange_weak(seen, threads))
+            {
+            }
+        }
+        return lineCost(from, to);
+    };
+    int parallelScans = vrp::twoOptTrips(trips, cost);
+
+    CHECK(parallelScans == 1);
+    CHECK(longTripThreads.load() == 4);
+    CHECK(trips == expected);
+}
+
+int main()
+{
+    testLongTripsUseAllThreads();
+    return CHECK_RESULT();
+}
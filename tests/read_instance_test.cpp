@@ -0,0 +1,101 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include <unistd.h>
+
+#include "../vrp-lib/vrp_solver.hpp"
+#include "check.hpp"
+
+static std::string temporaryFile(const std::string &name)
+{
+    return "/tmp/vrp_read_instance_test_" + std::to_string(getpid()) + "_" + name;
+}
+
+static vrp::Instance smallInstance()
+{
+    vrp::Instance instance;
+    instance.numberOfCustomers = 2;
+    instance.packageWeights = {0, 3, 4};
+    instance.roads = {{0, 1, 5}, {1, 2, 6}, {2, 0, 7}};
+    return instance;
+}
+
+static bool readFails(const std::string &filename)
+{
+    try
+    {
+        vrp::readInstance(filename, 10, 3);
+    }
+    catch (const std::runtime_error &)
+    {
+        return true;
+    }
+    return false;
+}
+
+static std::string fileBytes(const std::string &filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void writeBytes(const std::string &filename, const std::string &bytes)
+{
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    file.write(bytes.data(), bytes.size());
+}
+
+// A binary graph round-trips; cutting it short or inflating its counts is reported as an error
+// before the counts are used to allocate.
+static void testCorruptBinaryGraph()
+{
+    std::string filename = temporaryFile("graph.bin");
+    vrp::writeInstance(filename, smallInstance(), true);
+    vrp::Instance read = vrp::readInstance(filename, 10, 3);
+    CHECK(read.numberOfCustomers == 2);
+    CHECK(read.roads.size() == 3);
+    CHECK(read.roads[2].cost == 7);
+
+    std::string bytes = fileBytes(filename);
+    writeBytes(filename, bytes.substr(0, bytes.size() - 5));
+    CHECK(readFails(filename));
+
+    std::string hugeCities = bytes;
+    uint32_t cities = 0xfffffff0u;
+    hugeCities.replace(8, sizeof(cities), reinterpret_cast<const char *>(&cities), sizeof(cities));
+    writeBytes(filename, hugeCities);
+    CHECK(readFails(filename));
+
+    std::string hugeRoads = bytes;
+    uint64_t roads = uint64_t(1) << 60;
+    hugeRoads.replace(12 + 2 * sizeof(int32_t), sizeof(roads), reinterpret_cast<const char *>(&roads), sizeof(roads));
+    writeBytes(filename, hugeRoads);
+    CHECK(readFails(filename));
+
+    writeBytes(filename, "VRPG");
+    CHECK(readFails(filename));
+    std::remove(filename.c_str());
+}
+
+// Text counts that cannot fit in the file, or are negative, are rejected the same way.
+static void testCorruptTextGraph()
+{
+    std::string filename = temporaryFile("graph.txt");
+    writeBytes(filename, "2\n1 3\n2 4\n2000000000\n0 1 5\n");
+    CHECK(readFails(filename));
+    writeBytes(filename, "-3\n");
+    CHECK(readFails(filename));
+    writeBytes(filename, "2\n1 3\n2 4\n1\n0 1 5\n");
+    CHECK(!readFails(filename));
+    std::remove(filename.c_str());
+}
+
+int main()
+{
+    testCorruptBinaryGraph();
+    testCorruptTextGraph();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,28 @@
+#include <string>
+
+#include "../vrp-lib/result_writer.hpp"
+#include "check.hpp"
+
+static void testCsvDoublesQuotesInInstance()
+{
+    vrp::RunResult result;
+    result.engine = "local-search";
+    result.instance = "data/a \"quoted\", name.txt";
+    result.routes = {{0, 1, 0}};
+    std::string csv = vrp::formatCsv(result);
+    std::string row = csv.substr(csv.find('\n') + 1);
+    CHECK(row.rfind("local-search,\"data/a \"\"quoted\"\", name.txt\",", 0) == 0);
+}
+
+static void testCsvQuotesPlainInstance()
+{
+    CHECK(vrp::result_detail::csvQuote("graph_6.txt") == "\"graph_6.txt\"");
+    CHECK(vrp::result_detail::csvQuote("\"") == "\"\"\"\"");
+}
+
+int main()
+{
+    testCsvDoublesQuotesInInstance();
+    testCsvQuotesPlainInstance();
+    return CHECK_RESULT();
+}
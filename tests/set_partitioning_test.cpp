@@ -0,0 +1,49 @@
+#include <climits>
+#include <vector>
+
+#include "../vrp-lib/set_partitioning.hpp"
+#include "check.hpp"
+
+// Rows 0..3. The cheapest partition is {0, 1} + {2, 3} at 10; singletons cost 8 each.
+static std::vector<vrp::Column> pool()
+{
+    return {{{0}, 8}, {{1}, 8}, {{2}, 8}, {{3}, 8}, {{0, 1}, 5}, {{2, 3}, 5}, {{1, 2}, 3}, {{0, 3}, 9}};
+}
+
+// Only an exact cover that beats the incumbent is taken.
+static void testOfferIncumbent()
+{
+    vrp::SetPartitioningSolver solver(4, pool());
+    CHECK(!solver.offerIncumbent({0, 1, 2}));    // row 3 uncovered
+    CHECK(!solver.offerIncumbent({4, 6, 3}));    // row 1 twice
+    CHECK(solver.offerIncumbent({0, 1, 2, 3}));  // 32
+    CHECK(!solver.offerIncumbent({0, 4, 5}));    // row 0 twice
+    CHECK(solver.offerIncumbent({4, 5}));        // 10
+    CHECK(!solver.offerIncumbent({0, 1, 2, 3})); // dearer than 10
+    CHECK(solver.solution() == std::vector<int>({4, 5}));
+}
+
+// An unlimited search proves optimality; a node limit of one leaves a valid bound.
+static void testLimits()
+{
+    vrp::SetPartitioningSolver exact(4, pool());
+    CHECK(exact.solve() == 10);
+    CHECK(exact.optimal);
+    CHECK(exact.lowerBound == 10);
+
+    vrp::SetPartitioningSolver limited(4, pool());
+    limited.offerIncumbent({0, 1, 2, 3});
+    vrp::SetPartitioningLimits limits;
+    limits.nodeLimit = 1;
+    long long cost = limited.solve(limits);
+    CHECK(cost <= 32);
+    CHECK(limited.lowerBound <= 10);
+    CHECK(limited.optimal == (cost == limited.lowerBound));
+}
+
+int main()
+{
+    testOfferIncumbent();
+    testLimits();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,43 @@
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "../vrp-lib/telemetry.hpp"
+#include "check.hpp"
+
+// A dashboard that connects and then never reads fills the socket buffer within a few samples.
+// The reporter must keep running and stop() must return instead of blocking in send().
+static void testStalledReaderDoesNotBlock()
+{
+    std::string path = "/tmp/vrp_telemetry_test_" + std::to_string(getpid()) + ".sock";
+    int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    path.copy(address.sun_path, sizeof(address.sun_path) - 1);
+    unlink(path.c_str());
+    CHECK(bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0);
+    CHECK(listen(listenFd, 1) == 0);
+
+    // Many threads make every line several kilobytes long.
+    vrp::Telemetry telemetry(4096);
+    telemetry.start("unix:" + path, 5);
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    auto stopStart = std::chrono::steady_clock::now();
+    telemetry.stop();
+    CHECK(std::chrono::steady_clock::now() - stopStart < std::chrono::seconds(1));
+
+    close(listenFd);
+    unlink(path.c_str());
+}
+
+int main()
+{
+    // A send() that blocks would hang the test; fail it instead.
+    alarm(10);
+    testStalledReaderDoesNotBlock();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,34 @@
+#include <cstdlib>
+
+#include "../vrp-lib/trip_cache.hpp"
+#include "check.hpp"
+
+// Symmetric costs, so every trip ties with its reverse.
+static int symmetricCost(int from, int to)
+{
+    return 10 + std::abs(from - to);
+}
+
+// The stored order must depend only on the set, whichever permutation reaches the cache first.
+static void testOrderIndependentOfPermutation()
+{
+    const int ascending[] = {1, 2, 3};
+    const int descending[] = {3, 2, 1};
+    vrp::TripCache first(8, 64);
+    vrp::TripCache second(8, 64);
+    vrp::CachedTrip a = first.trip(ascending, 3, symmetricCost);
+    vrp::CachedTrip b = second.trip(descending, 3, symmetricCost);
+    CHECK(a.cost == b.cost);
+    CHECK(a.length == 3 && b.length == 3);
+    CHECK(a.order == b.order);
+
+    vrp::CachedTrip hit = first.trip(descending, 3, symmetricCost);
+    CHECK(first.hits() == 1);
+    CHECK(hit.order == a.order);
+}
+
+int main()
+{
+    testOrderIndependentOfPermutation();
+    return CHECK_RESULT();
+}
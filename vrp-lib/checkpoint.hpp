@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace vrp
+{
+
+// Search state of the global-search engines. Every frontier entry is the partial route of a
+// DFS stack item; the visited set, load and stop count are rebuilt from it on resume.
+struct Checkpoint
+{
+    int numberOfCities = 0;
+    int vehicleCapacity = 0;
+    int maxCitiesPerRoute = 0;
+    int lowerCost = 0;
+    std::vector<int> bestRoute;
+    long long nodesExpanded = 0;
+    long long elapsedMillis = 0;
+    std::vector<std::vector<int>> frontier;
+    std::vector<std::vector<int>> routes;
+};
+
+namespace checkpoint_detail
+{
+constexpr char MAGIC[4] = {'V', 'R', 'P', 'C'};
+constexpr uint32_t VERSION = 1;
+
+inline void putVarint(std::string &out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out += static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+inline uint64_t getVarint(const std::string &in, size_t &position)
+{
+    uint64_t value = 0;
+    for (int shift = 0; position < in.size() && shift < 64; shift += 7)
+    {
+        uint8_t byte = in[position++];
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+        {
+            return value;
+        }
+    }
+    throw std::runtime_error("Truncated checkpoint file.");
+}
+
+// Signed values (INT_MAX costs, -1 markers) go through zig-zag so small magnitudes stay short.
+inline void putSigned(std::string &out, int64_t value)
+{
+    putVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+inline int64_t getSigned(const std::string &in, size_t &position)
+{
+    uint64_t value = getVarint(in, position);
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+inline void putRoutes(std::string &out, const std::vector<std::vector<int>> &routes)
+{
+    putVarint(out, routes.size());
+    for (const auto &route : routes)
+    {
+        putVarint(out, route.size());
+        for (int city : route)
+        {
+            putVarint(out, city);
+        }
+    }
+}
+
+inline std::vector<std::vector<int>> getRoutes(const std::string &in, size_t &position)
+{
+    std::vector<std::vector<int>> routes(getVarint(in, position));
+    for (auto &route : routes)
+    {
+        route.resize(getVarint(in, position));
+        for (int &city : route)
+        {
+            city = getVarint(in, position);
+        }
+    }
+    return routes;
+}
+} // namespace checkpoint_detail
+
+// The file is written next to its final name and renamed, so a job killed mid-write keeps the
+// previous checkpoint intact.
+inline void writeCheckpoint(const std::string &filename, const Checkpoint &state)
+{
+    using namespace checkpoint_detail;
+    std::string out(MAGIC, sizeof(MAGIC));
+    putVarint(out, VERSION);
+    putVarint(out, state.numberOfCities);
+    putVarint(out, state.vehicleCapacity);
+    putVarint(out, state.maxCitiesPerRoute);
+    putSigned(out, state.lowerCost);
+    putVarint(out, state.bestRoute.size());
+    for (int city : state.bestRoute)
+    {
+        putVarint(out, city);
+    }
+    putVarint(out, state.nodesExpanded);
+    putVarint(out, state.elapsedMillis);
+    putRoutes(out, state.frontier);
+    putRoutes(out, state.routes);
+
+    std::string temporary = filename + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.write(out.data(), out.size()))
+        {
+            throw std::runtime_error("Failed to write checkpoint " + temporary + ".");
+        }
+    }
+    if (std::rename(temporary.c_str(), filename.c_str()) != 0)
+    {
+        throw std::runtime_error("Failed to replace checkpoint " + filename + ".");
+    }
+}
+
+// Returns false when there is no checkpoint to resume from.
+inline bool readCheckpoint(const std::string &filename, Checkpoint &state)
+{
+    using namespace checkpoint_detail;
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    std::string in((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (in.compare(0, sizeof(MAGIC), MAGIC, sizeof(MAGIC)) != 0)
+    {
+        throw std::runtime_error(filename + " is not a checkpoint file.");
+    }
+    size_t position = sizeof(MAGIC);
+    if (getVarint(in, position) != VERSION)
+    {
+        throw std::runtime_error("Unsupported checkpoint version in " + filename + ".");
+    }
+    state.numberOfCities = getVarint(in, position);
+    state.vehicleCapacity = getVarint(in, position);
+    state.maxCitiesPerRoute = getVarint(in, position);
+    state.lowerCost = getSigned(in, position);
+    state.bestRoute.resize(getVarint(in, position));
+    for (int &city : state.bestRoute)
+    {
+        city = getVarint(in, position);
+    }
+    state.nodesExpanded = getVarint(in, position);
+    state.elapsedMillis = getVarint(in, position);
+    state.frontier = getRoutes(in, position);
+    state.routes = getRoutes(in, position);
+    return true;
+}
+
+} // namespace vrp
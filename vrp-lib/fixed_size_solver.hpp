@@ -0,0 +1,204 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace vrp
+{
+
+// Largest instance, depot included, that has a compile-time specialized kernel.
+constexpr int MAX_FIXED_SIZE_CITIES = 17;
+
+struct FixedSizeResult
+{
+    long long cost = LLONG_MAX; // LLONG_MAX when no solution exists
+    std::vector<int> path;      // depot-separated trips, 0 1 2 0 3 0
+    long long nodesExpanded = 0;
+    bool timedOut = false;
+};
+
+// The exact branch and bound of VRPSolver::searchGlobal() for exactly N cities, depot included.
+// Costs, weights and bounds are fixed-size arrays (about 1.5 KB for N = 17, so the whole state
+// stays in L1), the unvisited set is a 32-bit mask and the candidate loop is unrolled at
+// compile time into one tryCity<City>() step per city. Candidates are tried in the same order
+// as the generic search, so both return the same route.
+template <int N>
+class FixedSizeSolver
+{
+    static_assert(N >= 2 && N <= 32, "The unvisited set is a 32-bit mask.");
+
+private:
+    static constexpr int MAX_PATH = 2 * N; // every city is followed by at most one depot visit
+
+    std::array<int, N * N> costs;
+    std::array<int, N> weights;
+    std::array<int, N> minIncoming;
+    int vehicleCapacity;
+    int maxCitiesPerRoute;
+    int noRoad;
+
+    std::array<int, MAX_PATH> path;
+    int pathLength = 0;
+    std::array<int, MAX_PATH> bestPath;
+    int bestLength = 0;
+    long long bestCost = LLONG_MAX;
+    long long nodesExpanded = 0;
+    double timeLimitMillis = 0;
+    std::chrono::steady_clock::time_point deadline;
+    bool timedOut = false;
+
+public:
+    // costMatrix is row-major N x N with noRoad where there is no road; packageWeights[0] is the depot.
+    FixedSizeSolver(const int *costMatrix, const int *packageWeights, int capacity, int maxStops, int noRoad)
+        : vehicleCapacity(capacity), maxCitiesPerRoute(maxStops), noRoad(noRoad)
+    {
+        for (int i = 0; i < N * N; ++i)
+        {
+            costs[i] = costMatrix[i];
+        }
+        for (int to = 0; to < N; ++to)
+        {
+            weights[to] = packageWeights[to];
+            minIncoming[to] = noRoad;
+            for (int from = 0; from < N; ++from)
+            {
+                if (from != to && costs[from * N + to] < minIncoming[to])
+                {
+                    minIncoming[to] = costs[from * N + to];
+                }
+            }
+        }
+    }
+
+    void solve(double limitMillis, FixedSizeResult &result)
+    {
+        timeLimitMillis = limitMillis;
+        deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(static_cast<long long>(limitMillis * 1000));
+        long long lowerBound = 0;
+        for (int city = 1; city < N; ++city)
+        {
+            lowerBound += minIncoming[city];
+        }
+        path[0] = 0;
+        pathLength = 1;
+        if (lowerBound < noRoad)
+        {
+            search(0, ((1u << (N - 1)) - 1) << 1, 0, 0, 0, 0, lowerBound, false);
+        }
+
+        result.cost = bestCost;
+        result.path.assign(bestPath.begin(), bestPath.begin() + bestLength);
+        result.nodesExpanded = nodesExpanded;
+        result.timedOut = timedOut;
+    }
+
+private:
+    int cost(int from, int to) const
+    {
+        return costs[from * N + to];
+    }
+
+    void search(int currentCity, uint32_t unvisited, int load, int stops, long long costSoFar,
+                int anchor, long long lowerBound, bool anchorVisited)
+    {
+        ++nodesExpanded;
+        if ((nodesExpanded & 4095) == 0 && timeLimitMillis > 0 && std::chrono::steady_clock::now() > deadline)
+        {
+            timedOut = true;
+        }
+        if (timedOut || costSoFar + lowerBound >= bestCost)
+        {
+            return;
+        }
+
+        if (currentCity == 0)
+        {
+            if (unvisited == 0)
+            {
+                bestCost = costSoFar;
+                bestPath = path;
+                bestLength = pathLength;
+                return;
+            }
+            anchor = __builtin_ctz(unvisited);
+            anchorVisited = false;
+        }
+        else if (anchorVisited && cost(currentCity, 0) != noRoad)
+        {
+            path[pathLength++] = 0;
+            search(0, unvisited, 0, 0, costSoFar + cost(currentCity, 0), anchor, lowerBound, false);
+            --pathLength;
+        }
+
+        if (stops == maxCitiesPerRoute)
+        {
+            return;
+        }
+        const int *row = &costs[currentCity * N];
+        expand(row, unvisited, load, stops, costSoFar, anchor, lowerBound, anchorVisited, std::make_integer_sequence<int, N - 1>{});
+    }
+
+    // A fold over the cities rather than a loop: GCC's unroll pragma on a loop around the
+    // recursive call duplicates the whole search body per iteration.
+    template <int... Offsets>
+    void expand(const int *row, uint32_t unvisited, int load, int stops, long long costSoFar,
+                int anchor, long long lowerBound, bool anchorVisited, std::integer_sequence<int, Offsets...>)
+    {
+        (tryCity<Offsets + 1>(row, unvisited, load, stops, costSoFar, anchor, lowerBound, anchorVisited), ...);
+    }
+
+    template <int City>
+    void tryCity(const int *row, uint32_t unvisited, int load, int stops, long long costSoFar,
+                 int anchor, long long lowerBound, bool anchorVisited)
+    {
+        int arc = row[City];
+        if (!(unvisited >> City & 1) || arc == noRoad || load + weights[City] > vehicleCapacity)
+        {
+            return;
+        }
+        path[pathLength++] = City;
+        search(City, unvisited & ~(1u << City), load + weights[City], stops + 1, costSoFar + arc,
+               anchor, lowerBound - minIncoming[City], anchorVisited || City == anchor);
+        --pathLength;
+    }
+};
+
+namespace fixed_size_detail
+{
+using Kernel = void (*)(const int *, const int *, int, int, int, double, FixedSizeResult &);
+
+template <int N>
+void solve(const int *costMatrix, const int *packageWeights, int capacity, int maxStops, int noRoad,
+           double timeLimitMillis, FixedSizeResult &result)
+{
+    FixedSizeSolver<N> solver(costMatrix, packageWeights, capacity, maxStops, noRoad);
+    solver.solve(timeLimitMillis, result);
+}
+
+// One kernel per size from 2 to MAX_FIXED_SIZE_CITIES.
+template <int... Offsets>
+constexpr std::array<Kernel, sizeof...(Offsets)> makeKernels(std::integer_sequence<int, Offsets...>)
+{
+    return {&solve<Offsets + 2>...};
+}
+} // namespace fixed_size_detail
+
+inline bool hasFixedSizeKernel(int numberOfCities)
+{
+    return numberOfCities >= 2 && numberOfCities <= MAX_FIXED_SIZE_CITIES;
+}
+
+// Runs the kernel instantiated for numberOfCities; callers check hasFixedSizeKernel() first
+// and keep their generic search as the fallback. A timeLimitMillis of 0 disables the limit.
+inline void solveFixedSize(int numberOfCities, const int *costMatrix, const int *packageWeights, int capacity,
+                           int maxStops, int noRoad, double timeLimitMillis, FixedSizeResult &result)
+{
+    static constexpr auto kernels = fixed_size_detail::makeKernels(std::make_integer_sequence<int, MAX_FIXED_SIZE_CITIES - 1>{});
+    kernels[numberOfCities - 2](costMatrix, packageWeights, capacity, maxStops, noRoad, timeLimitMillis, result);
+}
+
+} // namespace vrp
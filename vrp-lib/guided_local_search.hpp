@@ -0,0 +1,362 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <vector>
+
+#include "two_opt.hpp"
+
+namespace vrp
+{
+
+// How often guided local search has penalized every directed road. Counts live at the index
+// of the row-major numberOfCities x numberOfCities cost matrix, so the augmented cost of a
+// road is one extra load next to its cost, and two bytes per road keep the array at half the
+// size of the costs.
+class EdgePenalties
+{
+private:
+    int numberOfCities;
+    std::vector<uint16_t> counts;
+
+public:
+    explicit EdgePenalties(int numberOfCities)
+        : numberOfCities(numberOfCities), counts(static_cast<size_t>(numberOfCities) * numberOfCities, 0)
+    {
+    }
+
+    int operator()(int source, int destination) const
+    {
+        return counts[static_cast<size_t>(source) * numberOfCities + destination];
+    }
+
+    // False once the count has saturated.
+    bool increment(int source, int destination)
+    {
+        uint16_t &count = counts[static_cast<size_t>(source) * numberOfCities + destination];
+        if (count == UINT16_MAX)
+        {
+            return false;
+        }
+        ++count;
+        return true;
+    }
+};
+
+struct GuidedLocalSearchOptions
+{
+    // Either budget may be 0 for no limit; with both at 0 the search stops at the first optimum.
+    double timeLimitMillis = 0;
+    long long maxIterations = 0; // penalty rounds
+    double alpha = 0.3; // penalty weight relative to the average road cost of the first optimum
+};
+
+// Guided local search over a set of depot-to-depot trips (Voudouris and Tsang). The trips are
+// improved by 2-opt within a trip, relocation of one customer into another trip and swaps of
+// two customers between trips, each priced by its O(1) delta on the augmented cost
+// c(e) + lambda * p(e). One empty trip is always kept as a relocation target, so the search
+// can open a new trip. In every local optimum the roads of the solution with the highest
+// utility c(e) / (1 + p(e)) are penalized, which pushes the search out of it. Relocations and
+// swaps keep the real and the augmented cost up to date by their deltas, 2-opt re-prices the
+// one trip it changed, and the best solution by real cost is returned when the time or
+// iteration budget runs out.
+//
+// cost(from, to) returns a large value for missing roads so moves never introduce them.
+template <typename Cost>
+class GuidedLocalSearch
+{
+public:
+    using Trip = std::vector<int>;
+
+    long long iterations = 0;
+    long long moves = 0;
+    long long penalized = 0;
+    long long initialCost = 0;
+    long long bestCost = 0;
+
+private:
+    const std::vector<int> &weights;
+    int vehicleCapacity;
+    int maxCitiesPerRoute;
+    Cost cost;
+    EdgePenalties penalties;
+    long long lambda = 0;
+
+    std::vector<Trip> trips;
+    std::vector<int> loads;
+    long long realCost = 0;
+    long long augmentedCost = 0;
+
+public:
+    // weights is indexed by city number, with the depot at 0.
+    GuidedLocalSearch(int numberOfCities, const std::vector<int> &weights, int vehicleCapacity, int maxCitiesPerRoute, Cost cost)
+        : weights(weights), vehicleCapacity(vehicleCapacity), maxCitiesPerRoute(maxCitiesPerRoute), cost(cost), penalties(numberOfCities)
+    {
+    }
+
+    // Replaces solution, a list of trips that start and end at the depot, with the best one found.
+    void run(std::vector<Trip> &solution, const GuidedLocalSearchOptions &options)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(static_cast<long long>(options.timeLimitMillis * 1000));
+        trips = solution;
+        loads.assign(trips.size(), 0);
+        realCost = 0;
+        size_t roads = 0;
+        for (size_t t = 0; t < trips.size(); ++t)
+        {
+            for (size_t k = 1; k < trips[t].size(); ++k)
+            {
+                loads[t] += weights[trips[t][k]];
+                realCost += real(trips[t][k - 1], trips[t][k]);
+                ++roads;
+            }
+        }
+        augmentedCost = realCost;
+        initialCost = bestCost = realCost;
+        std::vector<Trip> best = trips;
+
+        bool unlimited = options.maxIterations == 0 && options.timeLimitMillis <= 0;
+        while (true)
+        {
+            descend();
+            if (realCost < bestCost)
+            {
+                bestCost = realCost;
+                best = trips;
+            }
+            if (unlimited || (options.maxIterations > 0 && iterations >= options.maxIterations) ||
+                (options.timeLimitMillis > 0 && std::chrono::steady_clock::now() >= deadline))
+            {
+                break;
+            }
+            if (lambda == 0)
+            {
+                lambda = std::max<long long>(1, static_cast<long long>(options.alpha * realCost / std::max<size_t>(roads, 1)));
+            }
+            penalize();
+            ++iterations;
+        }
+
+        solution.clear();
+        for (Trip &trip : best)
+        {
+            if (trip.size() > 2)
+            {
+                solution.push_back(std::move(trip));
+            }
+        }
+    }
+
+private:
+    // A trip emptied by a relocation is 0 -> 0, which costs nothing.
+    long long real(int source, int destination) const
+    {
+        return source == destination ? 0 : cost(source, destination);
+    }
+
+    long long augmented(int source, int destination) const
+    {
+        return real(source, destination) + lambda * penalties(source, destination);
+    }
+
+    long long tripCost(const Trip &trip, bool withPenalties) const
+    {
+        long long total = 0;
+        for (size_t k = 1; k < trip.size(); ++k)
+        {
+            total += withPenalties ? augmented(trip[k - 1], trip[k]) : real(trip[k - 1], trip[k]);
+        }
+        return total;
+    }
+
+    // Leaves exactly one empty trip 0 -> 0, which costs nothing, for relocations to open.
+    void keepOneEmptyTrip()
+    {
+        bool empty = false;
+        size_t kept = 0;
+        for (size_t t = 0; t < trips.size(); ++t)
+        {
+            if (trips[t].size() <= 2)
+            {
+                if (empty)
+                {
+                    continue;
+                }
+                empty = true;
+            }
+            if (kept != t)
+            {
+                trips[kept] = std::move(trips[t]);
+                loads[kept] = loads[t];
+            }
+            ++kept;
+        }
+        trips.resize(kept);
+        loads.resize(kept);
+        if (!empty)
+        {
+            trips.push_back({0, 0});
+            loads.push_back(0);
+        }
+    }
+
+    // First-improvement descent on the augmented cost until no move improves it.
+    void descend()
+    {
+        bool improved = true;
+        while (improved)
+        {
+            improved = false;
+            keepOneEmptyTrip();
+            for (Trip &trip : trips)
+            {
+                long long realBefore = tripCost(trip, false);
+                long long augmentedBefore = tripCost(trip, true);
+                if (twoOpt(trip, [this](int source, int destination)
+                           { return augmented(source, destination); }))
+                {
+                    realCost += tripCost(trip, false) - realBefore;
+                    augmentedCost += tripCost(trip, true) - augmentedBefore;
+                    ++moves;
+                    improved = true;
+                }
+            }
+            improved = relocate() || improved;
+            improved = swap() || improved;
+        }
+    }
+
+    // Moves one customer to the cheapest position of another trip with room for it.
+    bool relocate()
+    {
+        bool improved = false;
+        for (size_t a = 0; a < trips.size(); ++a)
+        {
+            for (size_t i = 1; i + 1 < trips[a].size(); ++i)
+            {
+                int before = trips[a][i - 1];
+                int customer = trips[a][i];
+                int after = trips[a][i + 1];
+                long long removal = augmented(before, after) - augmented(before, customer) - augmented(customer, after);
+                long long bestDelta = 0;
+                size_t bestTrip = 0;
+                size_t bestPosition = 0;
+                for (size_t b = 0; b < trips.size(); ++b)
+                {
+                    if (b == a || loads[b] + weights[customer] > vehicleCapacity ||
+                        static_cast<int>(trips[b].size()) - 2 >= maxCitiesPerRoute)
+                    {
+                        continue;
+                    }
+                    const Trip &target = trips[b];
+                    for (size_t j = 1; j < target.size(); ++j)
+                    {
+                        long long delta = removal + augmented(target[j - 1], customer) + augmented(customer, target[j]) - augmented(target[j - 1], target[j]);
+                        if (delta < bestDelta)
+                        {
+                            bestDelta = delta;
+                            bestTrip = b;
+                            bestPosition = j;
+                        }
+                    }
+                }
+                if (bestDelta < 0)
+                {
+                    Trip &target = trips[bestTrip];
+                    realCost += real(before, after) - real(before, customer) - real(customer, after) +
+                                real(target[bestPosition - 1], customer) + real(customer, target[bestPosition]) - real(target[bestPosition - 1], target[bestPosition]);
+                    augmentedCost += bestDelta;
+                    target.insert(target.begin() + bestPosition, customer);
+                    trips[a].erase(trips[a].begin() + i);
+                    loads[bestTrip] += weights[customer];
+                    loads[a] -= weights[customer];
+                    ++moves;
+                    improved = true;
+                    --i;
+                }
+            }
+        }
+        return improved;
+    }
+
+    // Exchanges two customers of different trips, each taking the other's place.
+    bool swap()
+    {
+        bool improved = false;
+        for (size_t a = 0; a < trips.size(); ++a)
+        {
+            for (size_t i = 1; i + 1 < trips[a].size(); ++i)
+            {
+                for (size_t b = a + 1; b < trips.size(); ++b)
+                {
+                    Trip &first = trips[a];
+                    Trip &second = trips[b];
+                    int u = first[i];
+                    for (size_t j = 1; j + 1 < second.size(); ++j)
+                    {
+                        int v = second[j];
+                        int shift = weights[v] - weights[u];
+                        if (loads[a] + shift > vehicleCapacity || loads[b] - shift > vehicleCapacity)
+                        {
+                            continue;
+                        }
+                        long long delta = augmented(first[i - 1], v) + augmented(v, first[i + 1]) - augmented(first[i - 1], u) - augmented(u, first[i + 1]) +
+                                          augmented(second[j - 1], u) + augmented(u, second[j + 1]) - augmented(second[j - 1], v) - augmented(v, second[j + 1]);
+                        if (delta >= 0)
+                        {
+                            continue;
+                        }
+                        realCost += real(first[i - 1], v) + real(v, first[i + 1]) - real(first[i - 1], u) - real(u, first[i + 1]) +
+                                    real(second[j - 1], u) + real(u, second[j + 1]) - real(second[j - 1], v) - real(v, second[j + 1]);
+                        augmentedCost += delta;
+                        std::swap(first[i], second[j]);
+                        loads[a] += shift;
+                        loads[b] -= shift;
+                        u = v;
+                        ++moves;
+                        improved = true;
+                    }
+                }
+            }
+        }
+        return improved;
+    }
+
+    // Penalizes the roads of the current solution with the highest utility; a road that is
+    // expensive and rarely penalized so far is the first one the search is steered away from.
+    void penalize()
+    {
+        double bestUtility = -1;
+        for (const Trip &trip : trips)
+        {
+            for (size_t k = 1; k < trip.size(); ++k)
+            {
+                bestUtility = std::max(bestUtility, utility(trip[k - 1], trip[k]));
+            }
+        }
+        for (const Trip &trip : trips)
+        {
+            if (trip.size() <= 2)
+            {
+                continue; // the spare empty trip has no road to penalize
+            }
+            for (size_t k = 1; k < trip.size(); ++k)
+            {
+                if (utility(trip[k - 1], trip[k]) >= bestUtility && penalties.increment(trip[k - 1], trip[k]))
+                {
+                    augmentedCost += lambda;
+                    ++penalized;
+                }
+            }
+        }
+    }
+
+    double utility(int source, int destination) const
+    {
+        return static_cast<double>(real(source, destination)) / (1 + penalties(source, destination));
+    }
+};
+
+} // namespace vrp
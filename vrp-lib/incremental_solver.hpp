@@ -0,0 +1,441 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <stdexcept>
+#include <vector>
+
+#include "two_opt.hpp"
+#include "vrp_solver.hpp"
+
+namespace vrp
+{
+
+// Keeps a graph and its last solution in memory so that small changes (a city's weight, a few
+// road costs, added or removed cities) only repair and re-improve the routes they touch.
+class IncrementalSolver
+{
+public:
+    static constexpr int NO_ROAD = VRPSolver::NO_ROAD;
+
+private:
+    int numberOfCities = 0; // depot included, removed cities keep their slot
+    int stride = 0;         // row length of costMatrix, grown geometrically by addCity()
+    int vehicleCapacity = 0;
+    int maxCitiesPerRoute = 0;
+    std::vector<int> weights;
+    std::vector<char> active;
+    std::vector<int> costMatrix;
+
+    std::vector<Route> routes;
+    std::vector<long long> routeCosts;
+    std::vector<int> routeLoads;
+    std::vector<int> routeOf; // -1 while a city waits for insertion
+    std::vector<int> unassigned;
+    std::vector<char> dirty;
+    long long movesApplied = 0;
+
+public:
+    explicit IncrementalSolver(const Instance &instance)
+        : numberOfCities(instance.numberOfCustomers + 1), stride(instance.numberOfCustomers + 1),
+          vehicleCapacity(instance.vehicleCapacity), maxCitiesPerRoute(instance.maxCitiesPerRoute),
+          weights(instance.packageWeights.begin(), instance.packageWeights.begin() + instance.numberOfCustomers + 1),
+          active(numberOfCities, 1), costMatrix(static_cast<size_t>(stride) * stride, NO_ROAD), routeOf(numberOfCities, -1)
+    {
+        for (const Edge &road : instance.roads)
+        {
+            int &slot = at(road.start, road.destination);
+            slot = std::min(slot, road.cost);
+        }
+    }
+
+    int cost(int from, int to) const
+    {
+        return costMatrix[static_cast<size_t>(from) * stride + to];
+    }
+
+    const std::vector<Route> &currentRoutes() const
+    {
+        return routes;
+    }
+
+    // Load of each route in currentRoutes().
+    const std::vector<int> &currentLoads() const
+    {
+        return routeLoads;
+    }
+
+    // Cold solve: nearest-neighbour trips as in the local engine, then every route is improved.
+    Solution solve(long long moveBudget = LLONG_MAX)
+    {
+        routes.clear();
+        routeCosts.clear();
+        routeLoads.clear();
+        dirty.clear();
+        unassigned.clear();
+        std::fill(routeOf.begin(), routeOf.end(), -1);
+
+        while (true)
+        {
+            Route trip{0};
+            int currentCity = 0;
+            int load = 0;
+            while (static_cast<int>(trip.size()) - 1 < maxCitiesPerRoute)
+            {
+                int nextCity = -1;
+                int minCost = NO_ROAD;
+                for (int city = 1; city < numberOfCities; ++city)
+                {
+                    if (active[city] && routeOf[city] == -1 && cost(currentCity, city) < minCost && load + weights[city] <= vehicleCapacity)
+                    {
+                        nextCity = city;
+                        minCost = cost(currentCity, city);
+                    }
+                }
+                if (nextCity == -1)
+                {
+                    break;
+                }
+                trip.push_back(nextCity);
+                routeOf[nextCity] = routes.size();
+                load += weights[nextCity];
+                currentCity = nextCity;
+            }
+            if (trip.size() == 1)
+            {
+                break;
+            }
+            trip.push_back(0);
+            routeCosts.push_back(routeCost(trip));
+            routeLoads.push_back(load);
+            dirty.push_back(1);
+            routes.push_back(std::move(trip));
+        }
+
+        for (int city = 1; city < numberOfCities; ++city)
+        {
+            if (active[city] && routeOf[city] == -1)
+            {
+                unassigned.push_back(city);
+            }
+        }
+        return reoptimize(moveBudget);
+    }
+
+    int addCity(int packageWeight)
+    {
+        if (numberOfCities == stride)
+        {
+            int newStride = std::max(2 * stride, 2);
+            std::vector<int> grown(static_cast<size_t>(newStride) * newStride, NO_ROAD);
+            for (int from = 0; from < numberOfCities; ++from)
+            {
+                std::copy(&costMatrix[static_cast<size_t>(from) * stride], &costMatrix[static_cast<size_t>(from) * stride] + numberOfCities,
+                          &grown[static_cast<size_t>(from) * newStride]);
+            }
+            costMatrix.swap(grown);
+            stride = newStride;
+        }
+        int city = numberOfCities++;
+        weights.push_back(packageWeight);
+        active.push_back(1);
+        routeOf.push_back(-1);
+        unassigned.push_back(city);
+        return city;
+    }
+
+    void removeCity(int city)
+    {
+        checkCity(city);
+        active[city] = 0;
+        detach(city);
+        unassigned.erase(std::remove(unassigned.begin(), unassigned.end(), city), unassigned.end());
+    }
+
+    void updateWeight(int city, int packageWeight)
+    {
+        checkCity(city);
+        int route = routeOf[city];
+        if (route >= 0)
+        {
+            routeLoads[route] += packageWeight - weights[city];
+        }
+        // detach() takes the city's current weight off its route.
+        weights[city] = packageWeight;
+        if (route >= 0)
+        {
+            markDirty(route);
+            if (routeLoads[route] > vehicleCapacity)
+            {
+                detach(city);
+                unassigned.push_back(city);
+            }
+        }
+    }
+
+    // NO_ROAD removes the road.
+    void updateRoad(int start, int destination, int roadCost)
+    {
+        if (start < 0 || start >= numberOfCities || destination < 0 || destination >= numberOfCities)
+        {
+            throw std::runtime_error("Road references an unknown city.");
+        }
+        at(start, destination) = roadCost;
+        for (int city : {start, destination})
+        {
+            int route = routeOf[city];
+            if (city != 0 && route >= 0)
+            {
+                routeCosts[route] = routeCost(routes[route]);
+                markDirty(route);
+            }
+        }
+        if (start == 0 || destination == 0)
+        {
+            // Depot roads can change any trip's first or last leg.
+            for (size_t route = 0; route < routes.size(); ++route)
+            {
+                if (routes[route][1] == destination || routes[route][routes[route].size() - 2] == start)
+                {
+                    routeCosts[route] = routeCost(routes[route]);
+                    markDirty(route);
+                }
+            }
+        }
+    }
+
+    // Inserts pending cities, then runs at most moveBudget improving moves over dirty routes.
+    Solution reoptimize(long long moveBudget = 1000)
+    {
+        auto startTime = std::chrono::steady_clock::now();
+        movesApplied = 0;
+        for (int city : unassigned)
+        {
+            insertCheapest(city);
+        }
+        unassigned.clear();
+
+        for (int route = 0; route < static_cast<int>(routes.size()) && movesApplied < moveBudget; ++route)
+        {
+            // Relocations can dirty earlier routes again, so restart the scan when that happens.
+            if (!dirty[route])
+            {
+                continue;
+            }
+            dirty[route] = 0;
+            int lowestTouched = improveRoute(route, moveBudget);
+            if (lowestTouched < route)
+            {
+                route = lowestTouched - 1;
+            }
+        }
+        dropEmptyRoutes();
+
+        Solution solution;
+        solution.routes = routes;
+        solution.cost = 0;
+        solution.feasible = true;
+        for (size_t route = 0; route < routes.size(); ++route)
+        {
+            solution.cost += routeCosts[route];
+            // A city heavier than a vehicle still gets a trip of its own, which no vehicle can drive.
+            solution.feasible = solution.feasible && routeCosts[route] < NO_ROAD && routeLoads[route] <= vehicleCapacity;
+        }
+        solution.nodesExpanded = movesApplied;
+        solution.solveMicros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+        return solution;
+    }
+
+private:
+    int &at(int from, int to)
+    {
+        return costMatrix[static_cast<size_t>(from) * stride + to];
+    }
+
+    void checkCity(int city) const
+    {
+        if (city <= 0 || city >= numberOfCities || !active[city])
+        {
+            throw std::runtime_error("Unknown city.");
+        }
+    }
+
+    long long routeCost(const Route &route) const
+    {
+        long long total = 0;
+        if (route.size() <= 2)
+        {
+            return total;
+        }
+        for (size_t i = 0; i + 1 < route.size(); ++i)
+        {
+            total += cost(route[i], route[i + 1]);
+        }
+        return total;
+    }
+
+    void markDirty(int route)
+    {
+        dirty[route] = 1;
+    }
+
+    void detach(int city)
+    {
+        int route = routeOf[city];
+        if (route < 0)
+        {
+            return;
+        }
+        Route &trip = routes[route];
+        trip.erase(std::find(trip.begin() + 1, trip.end() - 1, city));
+        routeLoads[route] -= weights[city];
+        routeCosts[route] = routeCost(trip);
+        routeOf[city] = -1;
+        markDirty(route);
+    }
+
+    // Cheapest position among trips with spare capacity and stops, or a new trip.
+    long long insertionDelta(int city, int route, size_t &bestPosition) const
+    {
+        const Route &trip = routes[route];
+        if (routeLoads[route] + weights[city] > vehicleCapacity || static_cast<int>(trip.size()) - 2 >= maxCitiesPerRoute)
+        {
+            return LLONG_MAX;
+        }
+        if (trip.size() == 2)
+        {
+            bestPosition = 1;
+            return static_cast<long long>(cost(0, city)) + cost(city, 0);
+        }
+        long long best = LLONG_MAX;
+        for (size_t position = 1; position < trip.size(); ++position)
+        {
+            long long delta = static_cast<long long>(cost(trip[position - 1], city)) + cost(city, trip[position]) -
+                              cost(trip[position - 1], trip[position]);
+            if (delta < best)
+            {
+                best = delta;
+                bestPosition = position;
+            }
+        }
+        return best;
+    }
+
+    void insertCheapest(int city)
+    {
+        long long bestDelta = static_cast<long long>(cost(0, city)) + cost(city, 0);
+        int bestRoute = -1;
+        size_t bestPosition = 0;
+        for (size_t route = 0; route < routes.size(); ++route)
+        {
+            size_t position = 0;
+            long long delta = insertionDelta(city, route, position);
+            if (delta < bestDelta)
+            {
+                bestDelta = delta;
+                bestRoute = route;
+                bestPosition = position;
+            }
+        }
+
+        if (bestRoute == -1)
+        {
+            bestRoute = routes.size();
+            routes.push_back({0, 0});
+            routeCosts.push_back(0);
+            routeLoads.push_back(0);
+            dirty.push_back(0);
+            bestPosition = 1;
+        }
+        Route &trip = routes[bestRoute];
+        trip.insert(trip.begin() + bestPosition, city);
+        routeCosts[bestRoute] = routeCost(trip);
+        routeLoads[bestRoute] += weights[city];
+        routeOf[city] = bestRoute;
+        markDirty(bestRoute);
+    }
+
+    // 2-opt inside the route, then relocations of its cities into other routes. Returns the
+    // lowest route index that was made dirty by a relocation.
+    int improveRoute(int route, long long moveBudget)
+    {
+        int lowestTouched = routes.size();
+        if (twoOpt(routes[route], [this](int from, int to)
+                   { return cost(from, to); }))
+        {
+            routeCosts[route] = routeCost(routes[route]);
+            ++movesApplied;
+        }
+
+        for (size_t index = 1; index + 1 < routes[route].size() && movesApplied < moveBudget; ++index)
+        {
+            Route &trip = routes[route];
+            int city = trip[index];
+            long long removalGain = static_cast<long long>(cost(trip[index - 1], city)) + cost(city, trip[index + 1]) -
+                                    (trip.size() == 3 ? 0 : cost(trip[index - 1], trip[index + 1]));
+            long long bestDelta = 0;
+            int bestRoute = -1;
+            size_t bestPosition = 0;
+            for (int other = 0; other < static_cast<int>(routes.size()); ++other)
+            {
+                size_t position = 0;
+                long long delta = other == route ? LLONG_MAX : insertionDelta(city, other, position);
+                if (delta != LLONG_MAX && delta - removalGain < bestDelta)
+                {
+                    bestDelta = delta - removalGain;
+                    bestRoute = other;
+                    bestPosition = position;
+                }
+            }
+            if (bestRoute == -1)
+            {
+                continue;
+            }
+
+            trip.erase(trip.begin() + index);
+            routeLoads[route] -= weights[city];
+            routeCosts[route] = routeCost(trip);
+            Route &target = routes[bestRoute];
+            target.insert(target.begin() + bestPosition, city);
+            routeLoads[bestRoute] += weights[city];
+            routeCosts[bestRoute] = routeCost(target);
+            routeOf[city] = bestRoute;
+            markDirty(bestRoute);
+            lowestTouched = std::min(lowestTouched, bestRoute);
+            ++movesApplied;
+            --index;
+        }
+        return lowestTouched;
+    }
+
+    void dropEmptyRoutes()
+    {
+        size_t kept = 0;
+        for (size_t route = 0; route < routes.size(); ++route)
+        {
+            if (routes[route].size() <= 2)
+            {
+                continue;
+            }
+            if (kept != route)
+            {
+                routes[kept] = std::move(routes[route]);
+                routeCosts[kept] = routeCosts[route];
+                routeLoads[kept] = routeLoads[route];
+                dirty[kept] = dirty[route];
+                for (size_t i = 1; i + 1 < routes[kept].size(); ++i)
+                {
+                    routeOf[routes[kept][i]] = kept;
+                }
+            }
+            ++kept;
+        }
+        routes.resize(kept);
+        routeCosts.resize(kept);
+        routeLoads.resize(kept);
+        dirty.resize(kept);
+    }
+};
+
+} // namespace vrp
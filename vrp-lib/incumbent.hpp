@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <vector>
+
+namespace vrp
+{
+
+// Best solution shared by many threads without a lock. The cost and the buffer slot holding
+// its route are packed into one atomic word: the cost in the high 32 bits, so a relaxed load
+// is enough to read the pruning bound, and thread * 2 + buffer in the low 32 bits. Every
+// thread owns two route buffers and always writes the one it did not publish last, so the
+// published route is never overwritten while it is still the incumbent.
+class Incumbent
+{
+public:
+    using Route = std::vector<int>;
+
+private:
+    static constexpr uint64_t EMPTY = static_cast<uint64_t>(UINT32_MAX) << 32;
+
+    struct alignas(64) Buffers
+    {
+        Route routes[2];
+        int next = 0;
+    };
+
+    alignas(64) std::atomic<uint64_t> packed{EMPTY};
+    std::vector<Buffers> buffers;
+
+public:
+    explicit Incumbent(int threads) : buffers(threads)
+    {
+    }
+
+    // Cost of the current incumbent, INT_MAX while there is none; may be slightly stale.
+    int bound() const
+    {
+        uint32_t cost = packed.load(std::memory_order_relaxed) >> 32;
+        return cost > INT_MAX ? INT_MAX : static_cast<int>(cost);
+    }
+
+    // Publishes the route if it is strictly cheaper than the incumbent; thread is the caller's
+    // index in [0, threads).
+    bool offer(int thread, int cost, const Route &route)
+    {
+        uint64_t current = packed.load(std::memory_order_relaxed);
+        if (static_cast<uint32_t>(cost) >= current >> 32)
+        {
+            return false;
+        }
+        Buffers &own = buffers[thread];
+        own.routes[own.next] = route;
+        uint64_t candidate = static_cast<uint64_t>(cost) << 32 | static_cast<uint32_t>(thread * 2 + own.next);
+        while (static_cast<uint32_t>(cost) < current >> 32)
+        {
+            if (packed.compare_exchange_weak(current, candidate, std::memory_order_release, std::memory_order_relaxed))
+            {
+                own.next ^= 1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Only meaningful once every offering thread has finished.
+    int cost() const
+    {
+        return bound();
+    }
+
+    const Route &route() const
+    {
+        static const Route none;
+        uint64_t current = packed.load(std::memory_order_acquire);
+        if (current == EMPTY)
+        {
+            return none;
+        }
+        uint32_t slot = static_cast<uint32_t>(current);
+        return buffers[slot / 2].routes[slot % 2];
+    }
+};
+
+} // namespace vrp
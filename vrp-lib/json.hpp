@@ -0,0 +1,291 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace vrp
+{
+
+// Minimal JSON value, enough for the line-delimited request protocol of vrp-server.
+class JsonValue
+{
+public:
+    enum class Type
+    {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object
+    };
+
+    Type type = Type::Null;
+    bool boolean = false;
+    double number = 0;
+    std::string text;
+    std::vector<JsonValue> items;
+    std::map<std::string, JsonValue> members;
+
+    static JsonValue parse(const std::string &input)
+    {
+        size_t position = 0;
+        JsonValue value = parseValue(input, position);
+        skipSpace(input, position);
+        if (position != input.size())
+        {
+            throw std::runtime_error("Trailing characters after JSON value.");
+        }
+        return value;
+    }
+
+    bool has(const std::string &key) const
+    {
+        return type == Type::Object && members.count(key) != 0;
+    }
+
+    const JsonValue &operator[](const std::string &key) const
+    {
+        auto it = members.find(key);
+        if (type != Type::Object || it == members.end())
+        {
+            throw std::runtime_error("Missing JSON field \"" + key + "\".");
+        }
+        return it->second;
+    }
+
+    int asInt() const
+    {
+        if (type != Type::Number)
+        {
+            throw std::runtime_error("Expected a JSON number.");
+        }
+        return static_cast<int>(number);
+    }
+
+    const std::string &asString() const
+    {
+        if (type != Type::String)
+        {
+            throw std::runtime_error("Expected a JSON string.");
+        }
+        return text;
+    }
+
+    int getInt(const std::string &key, int fallback) const
+    {
+        return has(key) ? (*this)[key].asInt() : fallback;
+    }
+
+    std::string getString(const std::string &key, const std::string &fallback) const
+    {
+        return has(key) ? (*this)[key].asString() : fallback;
+    }
+
+private:
+    static void skipSpace(const std::string &input, size_t &position)
+    {
+        while (position < input.size() && (input[position] == ' ' || input[position] == '\t' || input[position] == '\r' || input[position] == '\n'))
+        {
+            ++position;
+        }
+    }
+
+    static void expect(const std::string &input, size_t &position, const char *literal)
+    {
+        for (const char *c = literal; *c; ++c, ++position)
+        {
+            if (position >= input.size() || input[position] != *c)
+            {
+                throw std::runtime_error("Invalid JSON literal.");
+            }
+        }
+    }
+
+    static JsonValue parseValue(const std::string &input, size_t &position)
+    {
+        skipSpace(input, position);
+        if (position >= input.size())
+        {
+            throw std::runtime_error("Unexpected end of JSON.");
+        }
+
+        JsonValue value;
+        char c = input[position];
+        if (c == '{')
+        {
+            value.type = Type::Object;
+            ++position;
+            skipSpace(input, position);
+            if (position < input.size() && input[position] == '}')
+            {
+                ++position;
+                return value;
+            }
+            while (true)
+            {
+                skipSpace(input, position);
+                std::string key = parseString(input, position);
+                skipSpace(input, position);
+                expect(input, position, ":");
+                value.members[key] = parseValue(input, position);
+                skipSpace(input, position);
+                if (position < input.size() && input[position] == ',')
+                {
+                    ++position;
+                    continue;
+                }
+                expect(input, position, "}");
+                return value;
+            }
+        }
+        if (c == '[')
+        {
+            value.type = Type::Array;
+            ++position;
+            skipSpace(input, position);
+            if (position < input.size() && input[position] == ']')
+            {
+                ++position;
+                return value;
+            }
+            while (true)
+            {
+                value.items.push_back(parseValue(input, position));
+                skipSpace(input, position);
+                if (position < input.size() && input[position] == ',')
+                {
+                    ++position;
+                    continue;
+                }
+                expect(input, position, "]");
+                return value;
+            }
+        }
+        if (c == '"')
+        {
+            value.type = Type::String;
+            value.text = parseString(input, position);
+            return value;
+        }
+        if (c == 't')
+        {
+            expect(input, position, "true");
+            value.type = Type::Bool;
+            value.boolean = true;
+            return value;
+        }
+        if (c == 'f')
+        {
+            expect(input, position, "false");
+            value.type = Type::Bool;
+            return value;
+        }
+        if (c == 'n')
+        {
+            expect(input, position, "null");
+            return value;
+        }
+
+        const char *begin = input.c_str() + position;
+        char *end = nullptr;
+        value.number = std::strtod(begin, &end);
+        if (end == begin)
+        {
+            throw std::runtime_error("Invalid JSON value.");
+        }
+        value.type = Type::Number;
+        position += end - begin;
+        return value;
+    }
+
+    static std::string parseString(const std::string &input, size_t &position)
+    {
+        expect(input, position, "\"");
+        std::string result;
+        while (position < input.size() && input[position] != '"')
+        {
+            char c = input[position++];
+            if (c == '\\' && position < input.size())
+            {
+                char escaped = input[position++];
+                switch (escaped)
+                {
+                case 'n':
+                    result += '\n';
+                    break;
+                case 't':
+                    result += '\t';
+                    break;
+                case 'r':
+                    result += '\r';
+                    break;
+                case 'b':
+                    result += '\b';
+                    break;
+                case 'f':
+                    result += '\f';
+                    break;
+                case 'u':
+                    // Only the ASCII range is needed by the protocol.
+                    result += static_cast<char>(std::strtol(input.substr(position, 4).c_str(), nullptr, 16));
+                    position += 4;
+                    break;
+                default:
+                    result += escaped;
+                }
+            }
+            else
+            {
+                result += c;
+            }
+        }
+        expect(input, position, "\"");
+        return result;
+    }
+};
+
+inline std::string jsonEscape(const std::string &text)
+{
+    std::string result;
+    result.reserve(text.size() + 2);
+    for (char c : text)
+    {
+        switch (c)
+        {
+        case '"':
+            result += "\\\"";
+            break;
+        case '\\':
+            result += "\\\\";
+            break;
+        case '\n':
+            result += "\\n";
+            break;
+        case '\t':
+            result += "\\t";
+            break;
+        case '\r':
+            result += "\\r";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char buffer[8];
+                std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                result += buffer;
+            }
+            else
+            {
+                result += c;
+            }
+        }
+    }
+    return result;
+}
+
+} // namespace vrp
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include "two_level_list.hpp"
+
+namespace vrp
+{
+
+struct NeighborListSearchStats
+{
+    long long twoOptMoves = 0;
+    long long orOptMoves = 0;
+};
+
+// 2-opt and Or-opt on one long cyclic tour of the nodes 0..n-1 with symmetric costs, for routes
+// far too long to rescan every pair after every move:
+//  - only moves that add a road from a city to one of its candidate neighbours are tried,
+//    and the scan of a neighbour list stops once that road alone costs more than it can gain;
+//  - every city has a don't-look bit: a city whose moves all failed is skipped until a move
+//    changes one of the roads around it, so a pass only revisits the part of the tour that
+//    changed;
+//  - the tour is a TwoLevelList, so applying a move costs O(sqrt(n)) rather than O(n).
+// neighbors[c] lists c's candidates, cheapest first. The tour is rewritten in place.
+template <typename Cost>
+NeighborListSearchStats improveWithNeighborLists(std::vector<int> &tour, const std::vector<std::vector<int>> &neighbors, Cost cost)
+{
+    NeighborListSearchStats stats;
+    const int n = static_cast<int>(tour.size());
+    if (n < 5)
+    {
+        return stats;
+    }
+    TwoLevelList list(tour);
+    std::vector<char> queued(n, 1);
+    std::deque<int> queue(tour.begin(), tour.end());
+    auto wake = [&](int city)
+    {
+        if (!queued[city])
+        {
+            queued[city] = 1;
+            queue.push_back(city);
+        }
+    };
+
+    // Replaces roads (a, succ a) and (c, succ c) by (a, c) and (succ a, succ c), or the mirror
+    // move on the predecessors.
+    auto tryTwoOpt = [&](int a)
+    {
+        for (int forward = 1; forward >= 0; --forward)
+        {
+            int b = forward ? list.next(a) : list.prev(a);
+            long long removed = cost(a, b);
+            for (int c : neighbors[a])
+            {
+                long long gain = removed - cost(a, c);
+                if (gain <= 0)
+                {
+                    break;
+                }
+                int d = forward ? list.next(c) : list.prev(c);
+                if (c == b || d == a)
+                {
+                    continue;
+                }
+                if (gain + cost(c, d) - cost(b, d) > 0)
+                {
+                    if (forward)
+                    {
+                        list.reverse(b, c);
+                    }
+                    else
+                    {
+                        list.reverse(c, b);
+                    }
+                    wake(a);
+                    wake(b);
+                    wake(c);
+                    wake(d);
+                    ++stats.twoOptMoves;
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
+
+    // Moves the segment of up to three cities starting at a between two neighbouring cities
+    // elsewhere, in whichever orientation is cheaper. The move is three reversals:
+    // p S n .. x y  ->  p x .. n S' y  ->  p n .. x S' y, then S' itself if needed.
+    auto tryOrOpt = [&](int a)
+    {
+        int last = a;
+        for (int length = 1; length <= 3 && length + 3 <= n; ++length, last = list.next(last))
+        {
+            int p = list.prev(a);
+            int after = list.next(last);
+            long long removed = cost(p, a) + cost(last, after) - cost(p, after);
+            if (removed <= 0)
+            {
+                continue;
+            }
+            auto inSegment = [&](int city)
+            {
+                return city == a || city == last || (length == 3 && city == list.next(a));
+            };
+            for (int end : {a, last})
+            {
+                for (int c : neighbors[end])
+                {
+                    if (cost(end, c) >= removed)
+                    {
+                        break;
+                    }
+                    if (inSegment(c))
+                    {
+                        continue;
+                    }
+                    for (int e : {list.next(c), list.prev(c)})
+                    {
+                        if (inSegment(e))
+                        {
+                            continue;
+                        }
+                        int x = e == list.next(c) ? c : e;
+                        int y = list.next(x);
+                        long long keep = cost(x, a) + cost(last, y);
+                        long long flip = cost(x, last) + cost(a, y);
+                        if (removed + cost(x, y) - std::min(keep, flip) <= 0)
+                        {
+                            continue;
+                        }
+                        list.reverse(a, x);
+                        list.reverse(x, after);
+                        if (keep < flip)
+                        {
+                            list.reverse(last, a);
+                        }
+                        wake(p);
+                        wake(after);
+                        wake(a);
+                        wake(last);
+                        wake(x);
+                        wake(y);
+                        ++stats.orOptMoves;
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    };
+
+    while (!queue.empty())
+    {
+        int city = queue.front();
+        queue.pop_front();
+        queued[city] = 0;
+        while (tryTwoOpt(city) || tryOrOpt(city))
+        {
+        }
+    }
+    tour = list.tour(tour[0]);
+    return stats;
+}
+
+} // namespace vrp
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace vrp
+{
+
+// Parses a Linux cpu list such as "0-3,8,10-11".
+inline std::vector<int> parseCpuList(const std::string &text)
+{
+    std::vector<int> cpus;
+    std::stringstream ranges(text);
+    std::string range;
+    while (std::getline(ranges, range, ','))
+    {
+        if (range.find_first_not_of(" \n") == std::string::npos)
+        {
+            continue;
+        }
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; ++cpu)
+        {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+// CPUs of every NUMA node, read from /sys. Machines without that information are reported as
+// one node holding every CPU.
+class NumaTopology
+{
+private:
+    std::vector<std::vector<int>> nodeCpus;
+
+public:
+    static NumaTopology detect()
+    {
+        NumaTopology topology;
+        for (int node = 0;; ++node)
+        {
+            std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            if (!file.is_open())
+            {
+                break;
+            }
+            std::string text;
+            std::getline(file, text);
+            std::vector<int> cpus = parseCpuList(text);
+            if (!cpus.empty())
+            {
+                topology.nodeCpus.push_back(cpus);
+            }
+        }
+        if (topology.nodeCpus.empty())
+        {
+            std::vector<int> cpus(std::max(1u, std::thread::hardware_concurrency()));
+            for (size_t cpu = 0; cpu < cpus.size(); ++cpu)
+            {
+                cpus[cpu] = cpu;
+            }
+            topology.nodeCpus.push_back(cpus);
+        }
+        return topology;
+    }
+
+    int nodes() const
+    {
+        return nodeCpus.size();
+    }
+
+    int nodeOfCpu(int cpu) const
+    {
+        for (size_t node = 0; node < nodeCpus.size(); ++node)
+        {
+            if (std::find(nodeCpus[node].begin(), nodeCpus[node].end(), cpu) != nodeCpus[node].end())
+            {
+                return node;
+            }
+        }
+        return 0;
+    }
+
+    // Spreads threads over the nodes round-robin, so bandwidth-bound phases use every socket
+    // even at low thread counts. An affinity map, when given, overrides the placement.
+    int cpuForThread(int thread, const std::vector<int> &affinity = {}) const
+    {
+        if (!affinity.empty())
+        {
+            return affinity[thread % affinity.size()];
+        }
+        const std::vector<int> &cpus = nodeCpus[thread % nodeCpus.size()];
+        return cpus[(thread / nodeCpus.size()) % cpus.size()];
+    }
+};
+
+// Binds the calling thread to one CPU; returns false where that is not supported.
+inline bool pinCurrentThread(int cpu)
+{
+#ifdef __linux__
+    if (cpu < 0 || cpu >= CPU_SETSIZE)
+    {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+// One copy of a read-only array per node. The copies are allocated without being touched, so
+// the first thread writing a copy, which fill() expects to run on that node, decides where
+// its pages live.
+template <typename T>
+class NodeReplicas
+{
+private:
+    std::vector<std::unique_ptr<T[]>> copies;
+    size_t length = 0;
+
+public:
+    void allocate(int nodes, size_t size)
+    {
+        length = size;
+        copies.clear();
+        for (int node = 0; node < nodes; ++node)
+        {
+            copies.emplace_back(new T[size]);
+        }
+    }
+
+    void fill(int node, const T *source)
+    {
+        std::copy(source, source + length, copies[node].get());
+    }
+
+    const T *on(int node) const
+    {
+        return copies[node].get();
+    }
+};
+
+// Per-node work queues over an index range. Each node starts on its own contiguous share and
+// only steals chunks from other nodes once that share is exhausted.
+class NumaWorkQueues
+{
+private:
+    struct alignas(64) Queue
+    {
+        std::atomic<size_t> next{0};
+        size_t end = 0;
+    };
+
+    std::unique_ptr<Queue[]> queues;
+    int nodes = 0;
+    size_t chunk = 1;
+
+public:
+    NumaWorkQueues(int numberOfNodes, size_t count, size_t chunkSize)
+        : queues(new Queue[numberOfNodes]), nodes(numberOfNodes), chunk(std::max<size_t>(chunkSize, 1))
+    {
+        for (int node = 0; node < nodes; ++node)
+        {
+            queues[node].next = count * node / nodes;
+            queues[node].end = count * (node + 1) / nodes;
+        }
+    }
+
+    // Claims the next chunk for a thread on `node`; false once every queue is empty.
+    bool next(int node, size_t &begin, size_t &end)
+    {
+        for (int offset = 0; offset < nodes; ++offset)
+        {
+            Queue &queue = queues[(node + offset) % nodes];
+            if (queue.next.load(std::memory_order_relaxed) >= queue.end)
+            {
+                continue;
+            }
+            begin = queue.next.fetch_add(chunk, std::memory_order_relaxed);
+            if (begin < queue.end)
+            {
+                end = std::min(begin + chunk, queue.end);
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+} // namespace vrp
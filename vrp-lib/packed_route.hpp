@@ -0,0 +1,228 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace vrp
+{
+
+// Complete routes (every customer once, trips separated by the depot 0) stored back to back in
+// one byte array instead of one std::vector<int> each. A record holds the customers in visiting
+// order at the narrowest width that fits the city numbers (1, 2 or 4 bytes), followed by a
+// bitmap with one bit per customer that marks the last customer of each trip, so the depot
+// is never stored. On 7 customers a route takes 8 bytes instead of about 90 for a vector
+// with its heap block. Every record has the same size, so routes are addressed by index, hashed
+// and compared as plain bytes, and a whole store can be sent as one buffer.
+class PackedRoutes
+{
+public:
+    using Route = std::vector<int>;
+
+private:
+    int customers = 0;
+    int width = 1;
+    size_t recordBytes = 0;
+    std::vector<uint8_t> data;
+
+public:
+    PackedRoutes() = default;
+
+    // Routes over the cities 0..numberOfCities-1.
+    explicit PackedRoutes(int numberOfCities)
+        : customers(numberOfCities - 1), width(numberOfCities <= 256 ? 1 : numberOfCities <= 65536 ? 2 : 4),
+          recordBytes(static_cast<size_t>(customers) * width + (customers + 7) / 8)
+    {
+    }
+
+    size_t size() const
+    {
+        return recordBytes == 0 ? 0 : data.size() / recordBytes;
+    }
+
+    bool empty() const
+    {
+        return data.empty();
+    }
+
+    size_t memoryBytes() const
+    {
+        return data.capacity();
+    }
+
+    void clear()
+    {
+        data.clear();
+    }
+
+    void shrink_to_fit()
+    {
+        data.shrink_to_fit();
+    }
+
+    void reserve(size_t routes)
+    {
+        data.reserve(routes * recordBytes);
+    }
+
+    // route starts and ends at the depot and visits every customer once.
+    void push_back(const Route &route)
+    {
+        size_t offset = data.size();
+        data.resize(offset + recordBytes, 0);
+        uint8_t *record = &data[offset];
+        uint8_t *bitmap = record + static_cast<size_t>(customers) * width;
+        int k = 0;
+        for (size_t i = 1; i < route.size(); ++i)
+        {
+            if (route[i] == 0)
+            {
+                bitmap[(k - 1) / 8] |= static_cast<uint8_t>(1u << ((k - 1) % 8));
+                continue;
+            }
+            store(record, k++, route[i]);
+        }
+    }
+
+    // Appends the records of another store over the same cities.
+    void append(const PackedRoutes &other)
+    {
+        data.insert(data.end(), other.data.begin(), other.data.end());
+    }
+
+    // Appends one record of another store over the same cities, without decoding it.
+    void append(const PackedRoutes &other, size_t index)
+    {
+        const uint8_t *record = &other.data[index * recordBytes];
+        data.insert(data.end(), record, record + recordBytes);
+    }
+
+    void decode(size_t index, Route &route) const
+    {
+        const uint8_t *record = &data[index * recordBytes];
+        const uint8_t *bitmap = record + static_cast<size_t>(customers) * width;
+        route.assign(1, 0);
+        for (int k = 0; k < customers; ++k)
+        {
+            route.push_back(load(record, k));
+            if (bitmap[k / 8] >> (k % 8) & 1)
+            {
+                route.push_back(0);
+            }
+        }
+    }
+
+    Route operator[](size_t index) const
+    {
+        Route route;
+        decode(index, route);
+        return route;
+    }
+
+    std::vector<Route> unpack() const
+    {
+        std::vector<Route> routes(size());
+        for (size_t i = 0; i < routes.size(); ++i)
+        {
+            decode(i, routes[i]);
+        }
+        return routes;
+    }
+
+    // 64-bit hash of the record, read 8 bytes at a time.
+    uint64_t hash(size_t index) const
+    {
+        const uint8_t *record = &data[index * recordBytes];
+        uint64_t h = 0x9e3779b97f4a7c15ull ^ recordBytes;
+        size_t offset = 0;
+        for (; offset + 8 <= recordBytes; offset += 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, record + offset, 8);
+            h = mix(h ^ word);
+        }
+        uint64_t tail = 0;
+        std::memcpy(&tail, record + offset, recordBytes - offset);
+        return mix(h ^ tail);
+    }
+
+    // Upper bound on the number of distinct records: an order of the customers and a trip end
+    // after any but the last of them. Saturates at SIZE_MAX.
+    size_t distinctRoutes() const
+    {
+        size_t count = 1;
+        for (int k = 1; k <= customers; ++k)
+        {
+            size_t factor = k < customers ? 2 * static_cast<size_t>(k) : static_cast<size_t>(k);
+            if (count > SIZE_MAX / factor)
+            {
+                return SIZE_MAX;
+            }
+            count *= factor;
+        }
+        return count;
+    }
+
+    bool equal(size_t first, size_t second) const
+    {
+        return std::memcmp(&data[first * recordBytes], &data[second * recordBytes], recordBytes) == 0;
+    }
+
+    const uint8_t *bytes() const
+    {
+        return data.data();
+    }
+
+    size_t byteSize() const
+    {
+        return data.size();
+    }
+
+private:
+    static uint64_t mix(uint64_t h)
+    {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return h;
+    }
+
+    void store(uint8_t *record, int k, int city) const
+    {
+        if (width == 1)
+        {
+            record[k] = static_cast<uint8_t>(city);
+        }
+        else if (width == 2)
+        {
+            uint16_t value = static_cast<uint16_t>(city);
+            std::memcpy(record + 2 * k, &value, 2);
+        }
+        else
+        {
+            uint32_t value = static_cast<uint32_t>(city);
+            std::memcpy(record + 4 * k, &value, 4);
+        }
+    }
+
+    int load(const uint8_t *record, int k) const
+    {
+        if (width == 1)
+        {
+            return record[k];
+        }
+        if (width == 2)
+        {
+            uint16_t value;
+            std::memcpy(&value, record + 2 * k, 2);
+            return value;
+        }
+        uint32_t value;
+        std::memcpy(&value, record + 4 * k, 4);
+        return static_cast<int>(value);
+    }
+};
+
+} // namespace vrp
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <tuple>
+#include <vector>
+
+namespace vrp
+{
+
+// Routes with fewer cities than this are scanned on one thread. A scan costs about
+// length^2 / 2 delta evaluations of a few nanoseconds each, so below this length the fork and
+// join of a parallel region cost more than the scan itself.
+constexpr size_t PARALLEL_TWO_OPT_MIN_LENGTH = 256;
+
+// Reversal of route[i..j]; delta is the change in route cost, i == 0 when there is none.
+struct TwoOptMove
+{
+    long long delta = 0;
+    int i = 0;
+    int j = 0;
+
+    // Cheaper first, ties to the smallest (i, j), so the best move does not depend on which
+    // thread evaluated it.
+    bool betterThan(const TwoOptMove &other) const
+    {
+        return std::tie(delta, i, j) < std::tie(other.delta, other.i, other.j);
+    }
+};
+
+#pragma omp declare reduction(bestTwoOptMove : TwoOptMove : omp_out = omp_in.betterThan(omp_out) ? omp_in : omp_out) \
+    initializer(omp_priv = TwoOptMove())
+
+// The cheapest improving reversal of a depot-to-depot route. Every i owns a row of moves whose
+// reversed-segment cost is accumulated as j grows, so each move is priced in O(1). Rows are
+// shared out dynamically (they shrink with i); each thread keeps its own best move and a
+// min-reduction picks the global one, so the route is only read during the scan. Inside an
+// active parallel region the scan runs on the calling thread.
+template <typename Cost>
+TwoOptMove bestTwoOptMove(const std::vector<int> &route, Cost cost, bool parallel)
+{
+    TwoOptMove best;
+    const int last = static_cast<int>(route.size()) - 2;
+
+#pragma omp parallel for schedule(dynamic, 8) reduction(bestTwoOptMove : best) if (parallel)
+    for (int i = 1; i < last; ++i)
+    {
+        long long reversedDelta = 0;
+        long long removed = static_cast<long long>(cost(route[i - 1], route[i]));
+        for (int j = i + 1; j <= last; ++j)
+        {
+            reversedDelta += static_cast<long long>(cost(route[j], route[j - 1])) - cost(route[j - 1], route[j]);
+            long long delta = reversedDelta + cost(route[i - 1], route[j]) + cost(route[i], route[j + 1]) - removed - cost(route[j], route[j + 1]);
+            if (delta < 0 && delta <= best.delta && TwoOptMove{delta, i, j}.betterThan(best))
+            {
+                best = {delta, i, j};
+            }
+        }
+    }
+    return best;
+}
+
+// Best-improvement 2-opt: applies the cheapest reversal until none improves the route. Routes of
+// at least parallelMinLength cities are scanned in parallel; the result is the same either way.
+// cost(a, b) must return a large value for missing roads so moves onto them are never taken.
+template <typename Cost>
+bool twoOptBestImprovement(std::vector<int> &route, Cost cost, size_t parallelMinLength = PARALLEL_TWO_OPT_MIN_LENGTH)
+{
+    bool improved = false;
+    while (true)
+    {
+        TwoOptMove move = bestTwoOptMove(route, cost, route.size() >= parallelMinLength);
+        if (move.i == 0)
+        {
+            return improved;
+        }
+        std::reverse(route.begin() + move.i, route.begin() + move.j + 1);
+        improved = true;
+    }
+}
+
+// Best-improvement 2-opt over a whole solution. Trips shorter than parallelMinLength are shared
+// out over the threads, one trip per iteration; the longer ones are then improved one after
+// another, each scan split over all threads. Call it outside any parallel region, or the long
+// trips fall back to a serial scan. Returns the number of trips that used the parallel scan.
+template <typename Cost>
+int twoOptTrips(std::vector<std::vector<int>> &trips, Cost cost, size_t parallelMinLength = PARALLEL_TWO_OPT_MIN_LENGTH)
+{
+    const int count = static_cast<int>(trips.size());
+
+#pragma omp parallel for schedule(dynamic)
+    for (int t = 0; t < count; ++t)
+    {
+        if (trips[t].size() < parallelMinLength)
+        {
+            twoOptBestImprovement(trips[t], cost, parallelMinLength);
+        }
+    }
+
+    int parallelScans = 0;
+    for (std::vector<int> &trip : trips)
+    {
+        if (trip.size() >= parallelMinLength)
+        {
+            twoOptBestImprovement(trip, cost, parallelMinLength);
+            ++parallelScans;
+        }
+    }
+    return parallelScans;
+}
+
+} // namespace vrp
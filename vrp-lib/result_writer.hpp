@@ -0,0 +1,220 @@
+#pragma once
+
+#include <charconv>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "json.hpp"
+
+namespace vrp
+{
+
+enum class OutputFormat
+{
+    Text,
+    Json,
+    Csv
+};
+
+inline OutputFormat parseOutputFormat(const std::string &name)
+{
+    if (name == "text")
+    {
+        return OutputFormat::Text;
+    }
+    if (name == "json")
+    {
+        return OutputFormat::Json;
+    }
+    if (name == "csv")
+    {
+        return OutputFormat::Csv;
+    }
+    throw std::runtime_error("Unknown output format " + name + ".");
+}
+
+// Everything an engine reports about one run.
+struct RunResult
+{
+    std::string engine;
+    std::string instance;
+    int cities = 0; // customers, depot excluded
+    long long roads = 0;
+    int vehicleCapacity = 0;
+    int maxCitiesPerRoute = 0;
+    long long cost = 0;
+    std::vector<std::vector<int>> routes; // depot-to-depot trips
+    std::vector<std::pair<std::string, double>> timingsMillis;
+    int threads = 1;
+    int ranks = 1;
+    std::vector<long long> rankCosts; // MPI engines only
+    std::vector<std::pair<std::string, long long>> counters;
+};
+
+// Cuts a depot-separated sequence such as 0 1 2 0 3 0 into trips [0 1 2 0] [0 3 0].
+inline std::vector<std::vector<int>> splitTrips(const std::vector<int> &sequence)
+{
+    std::vector<std::vector<int>> trips;
+    std::vector<int> trip{0};
+    for (size_t i = 1; i < sequence.size(); ++i)
+    {
+        trip.push_back(sequence[i]);
+        if (sequence[i] == 0)
+        {
+            if (trip.size() > 2)
+            {
+                trips.push_back(trip);
+            }
+            trip.assign(1, 0);
+        }
+    }
+    return trips;
+}
+
+namespace result_detail
+{
+inline void appendNumber(std::string &out, long long value)
+{
+    char digits[24];
+    out.append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr);
+}
+
+inline void appendNumber(std::string &out, double value)
+{
+    char digits[32];
+    int length = std::snprintf(digits, sizeof(digits), "%.3f", value);
+    out.append(digits, length);
+}
+
+// Wraps a CSV field in quotes, doubling any quote inside it.
+inline std::string csvQuote(const std::string &field)
+{
+    std::string out = "\"";
+    for (char c : field)
+    {
+        if (c == '"')
+        {
+            out += '"';
+        }
+        out += c;
+    }
+    return out + '"';
+}
+
+// JSON arrays [[0,1,0],[0,2,0]] when json is set, "0 1 0|0 2 0" for CSV otherwise.
+inline void appendRoutes(std::string &out, const std::vector<std::vector<int>> &routes, bool json)
+{
+    out += json ? "[" : "";
+    for (size_t r = 0; r < routes.size(); ++r)
+    {
+        out += r == 0 ? "" : json ? "," : "|";
+        out += json ? "[" : "";
+        for (size_t i = 0; i < routes[r].size(); ++i)
+        {
+            if (i > 0)
+            {
+                out += json ? ',' : ' ';
+            }
+            appendNumber(out, static_cast<long long>(routes[r][i]));
+        }
+        out += json ? "]" : "";
+    }
+    out += json ? "]" : "";
+}
+} // namespace result_detail
+
+inline std::string formatJson(const RunResult &result)
+{
+    using namespace result_detail;
+    std::string out = "{\"engine\":\"" + jsonEscape(result.engine) + "\",\"instance\":{\"file\":\"" + jsonEscape(result.instance) + "\",\"cities\":";
+    appendNumber(out, static_cast<long long>(result.cities));
+    out += ",\"roads\":";
+    appendNumber(out, result.roads);
+    out += "},\"parameters\":{\"vehicleCapacity\":";
+    appendNumber(out, static_cast<long long>(result.vehicleCapacity));
+    out += ",\"maxCitiesPerRoute\":";
+    appendNumber(out, static_cast<long long>(result.maxCitiesPerRoute));
+    out += ",\"threads\":";
+    appendNumber(out, static_cast<long long>(result.threads));
+    out += ",\"ranks\":";
+    appendNumber(out, static_cast<long long>(result.ranks));
+    out += "},\"cost\":";
+    appendNumber(out, result.cost);
+    out += ",\"routes\":";
+    appendRoutes(out, result.routes, true);
+    out += ",\"timingsMs\":{";
+    for (size_t i = 0; i < result.timingsMillis.size(); ++i)
+    {
+        out += (i > 0 ? ",\"" : "\"") + jsonEscape(result.timingsMillis[i].first) + "\":";
+        appendNumber(out, result.timingsMillis[i].second);
+    }
+    out += "},\"counters\":{";
+    for (size_t i = 0; i < result.counters.size(); ++i)
+    {
+        out += (i > 0 ? ",\"" : "\"") + jsonEscape(result.counters[i].first) + "\":";
+        appendNumber(out, result.counters[i].second);
+    }
+    out += '}';
+    if (!result.rankCosts.empty())
+    {
+        out += ",\"rankCosts\":[";
+        for (size_t i = 0; i < result.rankCosts.size(); ++i)
+        {
+            out += i > 0 ? "," : "";
+            appendNumber(out, result.rankCosts[i]);
+        }
+        out += ']';
+    }
+    out += "}\n";
+    return out;
+}
+
+// Header plus one row; timing and counter columns are named after their keys, trips are
+// separated by '|' and cities by spaces.
+inline std::string formatCsv(const RunResult &result)
+{
+    using namespace result_detail;
+    std::string out = "engine,instance,cities,roads,vehicle_capacity,max_cities_per_route,threads,ranks,cost";
+    for (const auto &timing : result.timingsMillis)
+    {
+        out += "," + timing.first + "_ms";
+    }
+    for (const auto &counter : result.counters)
+    {
+        out += "," + counter.first;
+    }
+    out += ",routes\n" + result.engine + "," + csvQuote(result.instance) + ",";
+    for (long long value : {static_cast<long long>(result.cities), result.roads, static_cast<long long>(result.vehicleCapacity),
+                            static_cast<long long>(result.maxCitiesPerRoute), static_cast<long long>(result.threads),
+                            static_cast<long long>(result.ranks), result.cost})
+    {
+        appendNumber(out, value);
+        out += ',';
+    }
+    for (const auto &timing : result.timingsMillis)
+    {
+        appendNumber(out, timing.second);
+        out += ',';
+    }
+    for (const auto &counter : result.counters)
+    {
+        appendNumber(out, counter.second);
+        out += ',';
+    }
+    appendRoutes(out, result.routes, false);
+    out += '\n';
+    return out;
+}
+
+// The whole document is formatted first and written with a single call.
+inline void writeResult(const RunResult &result, OutputFormat format)
+{
+    std::string out = format == OutputFormat::Csv ? formatCsv(result) : formatJson(result);
+    std::fwrite(out.data(), 1, out.size(), stdout);
+    std::fflush(stdout);
+}
+
+} // namespace vrp
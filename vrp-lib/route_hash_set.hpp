@@ -0,0 +1,149 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "packed_route.hpp"
+#include "telemetry.hpp"
+
+namespace vrp
+{
+
+// Set of distinct routes of a PackedRoutes store, filled by many threads at once without a
+// lock. It is an open-addressing table of record indices: a thread claims an empty slot with
+// one CAS, and a full slot is only a duplicate if the fingerprint bits kept next to its index
+// and then its bytes match. Nothing is ever removed, so a published slot never changes.
+// Compared with a std::set<Route>, an insert costs a hash and usually one probe instead of
+// log n vector comparisons and a node allocation, and the table takes 16 bytes per route.
+class RouteHashSet
+{
+private:
+    static constexpr int INDEX_BITS = 40;
+    static constexpr uint64_t INDEX_MASK = (uint64_t(1) << INDEX_BITS) - 1;
+
+    const PackedRoutes &routes;
+    std::unique_ptr<std::atomic<uint64_t>[]> slots; // fingerprint tag | record index + 1, 0 while empty
+    size_t mask;
+
+public:
+    // expected is the number of routes that will be inserted; the table never needs more
+    // room than the number of distinct routes the store can hold.
+    RouteHashSet(const PackedRoutes &routes, size_t expected) : routes(routes)
+    {
+        expected = std::min(expected, routes.distinctRoutes());
+        size_t capacity = 16;
+        while (capacity < 2 * expected)
+        {
+            capacity <<= 1;
+        }
+        slots.reset(new std::atomic<uint64_t>[capacity]());
+        mask = capacity - 1;
+    }
+
+    // True if no route equal to routes[index] was inserted before. Each index is inserted at
+    // most once, by any thread.
+    bool insert(size_t index)
+    {
+        uint64_t fingerprint = routes.hash(index);
+        uint64_t tag = fingerprint & ~INDEX_MASK;
+        uint64_t entry = tag | (index + 1);
+        for (size_t slot = fingerprint & mask;; slot = (slot + 1) & mask)
+        {
+            uint64_t current = slots[slot].load(std::memory_order_acquire);
+            if (current == 0 &&
+                slots[slot].compare_exchange_strong(current, entry, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                return true;
+            }
+            // current now holds the route that owns the slot.
+            if ((current & ~INDEX_MASK) == tag && routes.equal((current & INDEX_MASK) - 1, index))
+            {
+                return false;
+            }
+        }
+    }
+};
+
+// The routes of a store whose every leg has a road in the dense roadCosts matrix (INT_MAX where
+// there is none), each once, in store order. Engines built with -fopenmp validate and insert on
+// all their threads and only merge the lists of kept indices under the lock; the others run it
+// serially. Threads are shown busy in telemetry, if given.
+inline PackedRoutes uniqueValidRoutes(const PackedRoutes &routes, int numberOfCities, const std::vector<int> &roadCosts,
+                                      Telemetry *telemetry = nullptr)
+{
+    std::vector<char> valid(routes.size(), 0);
+    size_t validCount = 0;
+    std::unique_ptr<RouteHashSet> unique;
+    std::vector<size_t> kept;
+
+#pragma omp parallel
+    {
+#ifdef _OPENMP
+        int thread = omp_get_thread_num();
+#else
+        int thread = 0;
+#endif
+        if (telemetry)
+        {
+            telemetry->thread(thread).setBusy(true);
+        }
+        size_t threadValid = 0;
+        PackedRoutes::Route route;
+#pragma omp for schedule(dynamic, 1024) nowait
+        for (size_t i = 0; i < routes.size(); ++i)
+        {
+            routes.decode(i, route);
+            bool routeIsValid = true;
+            for (size_t j = 0; j + 1 < route.size() && routeIsValid; ++j)
+            {
+                routeIsValid = roadCosts[static_cast<size_t>(route[j]) * numberOfCities + route[j + 1]] != INT_MAX;
+            }
+            if (routeIsValid)
+            {
+                valid[i] = 1;
+                ++threadValid;
+            }
+        }
+        // Most enumerated routes use a missing road, so the set is sized by the valid ones.
+#pragma omp atomic
+        validCount += threadValid;
+#pragma omp barrier
+#pragma omp single
+        unique = std::make_unique<RouteHashSet>(routes, validCount);
+
+        std::vector<size_t> threadKept;
+#pragma omp for schedule(dynamic, 1024) nowait
+        for (size_t i = 0; i < routes.size(); ++i)
+        {
+            if (valid[i] && unique->insert(i))
+            {
+                threadKept.push_back(i);
+            }
+        }
+#pragma omp critical
+        kept.insert(kept.end(), threadKept.begin(), threadKept.end());
+        if (telemetry)
+        {
+            telemetry->thread(thread).setBusy(false);
+        }
+    }
+
+    std::sort(kept.begin(), kept.end());
+    PackedRoutes validRoutes(numberOfCities);
+    validRoutes.reserve(kept.size());
+    for (size_t i : kept)
+    {
+        validRoutes.append(routes, i);
+    }
+    return validRoutes;
+}
+
+} // namespace vrp
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "checkpoint.hpp"
+#include "packed_route.hpp"
+
+namespace vrp
+{
+
+// Complete routes moved out of memory once an enumeration outgrows its memory budget. Each
+// write() appends one segment to an anonymous file in the spill directory; the file is unlinked
+// as soon as it is created, so nothing is left behind when the process ends, however it ends.
+// Routes are stored as the length of the prefix they share with the previous route of the
+// segment, then the remaining cities, all as varints. Routes enumerated in DFS order share
+// most of their prefix, so a route usually takes a few bytes instead of 4 per city.
+class RouteSpill
+{
+private:
+    struct Segment
+    {
+        off_t offset;
+        size_t bytes;
+        size_t routes;
+    };
+
+    int numberOfCities;
+    int fd = -1;
+    off_t end = 0;
+    std::vector<Segment> segmentList;
+    long long routeCount = 0;
+
+public:
+    RouteSpill(const std::string &directory, int numberOfCities) : numberOfCities(numberOfCities)
+    {
+        std::string path = (directory.empty() ? std::string(".") : directory) + "/vrp-spill-XXXXXX";
+        fd = mkstemp(&path[0]);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Failed to create a spill file in " + directory + ".");
+        }
+        unlink(path.c_str());
+    }
+
+    ~RouteSpill()
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+
+    RouteSpill(const RouteSpill &) = delete;
+    RouteSpill &operator=(const RouteSpill &) = delete;
+
+    void write(const PackedRoutes &routes)
+    {
+        using namespace checkpoint_detail;
+        std::string out;
+        std::vector<int> previous;
+        std::vector<int> route;
+        for (size_t r = 0; r < routes.size(); ++r)
+        {
+            routes.decode(r, route);
+            size_t shared = 0;
+            while (shared < previous.size() && shared < route.size() && previous[shared] == route[shared])
+            {
+                ++shared;
+            }
+            putVarint(out, shared);
+            putVarint(out, route.size() - shared);
+            for (size_t k = shared; k < route.size(); ++k)
+            {
+                putVarint(out, route[k]);
+            }
+            previous.swap(route);
+        }
+        for (size_t written = 0; written < out.size();)
+        {
+            ssize_t count = pwrite(fd, out.data() + written, out.size() - written, end + static_cast<off_t>(written));
+            if (count < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (count <= 0)
+            {
+                throw std::runtime_error("Failed to write spilled routes.");
+            }
+            written += static_cast<size_t>(count);
+        }
+        segmentList.push_back({end, out.size(), routes.size()});
+        end += static_cast<off_t>(out.size());
+        routeCount += static_cast<long long>(routes.size());
+    }
+
+    // Calls visit(routes) with the routes of every segment in turn, so only one segment is in
+    // memory at a time.
+    template <typename Visit>
+    void forEachSegment(Visit visit) const
+    {
+        using namespace checkpoint_detail;
+        std::string in;
+        std::vector<int> route;
+        for (const Segment &segment : segmentList)
+        {
+            in.resize(segment.bytes);
+            for (size_t read = 0; read < segment.bytes;)
+            {
+                ssize_t count = pread(fd, &in[read], segment.bytes - read, segment.offset + static_cast<off_t>(read));
+                if (count < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (count <= 0)
+                {
+                    throw std::runtime_error("Failed to read spilled routes.");
+                }
+                read += static_cast<size_t>(count);
+            }
+            PackedRoutes routes(numberOfCities);
+            routes.reserve(segment.routes);
+            size_t position = 0;
+            for (size_t r = 0; r < segment.routes; ++r)
+            {
+                size_t shared = getVarint(in, position);
+                size_t rest = getVarint(in, position);
+                route.resize(shared);
+                for (size_t k = 0; k < rest; ++k)
+                {
+                    route.push_back(static_cast<int>(getVarint(in, position)));
+                }
+                routes.push_back(route);
+            }
+            visit(routes);
+        }
+    }
+
+    size_t segments() const
+    {
+        return segmentList.size();
+    }
+
+    long long routes() const
+    {
+        return routeCount;
+    }
+
+    long long bytes() const
+    {
+        return static_cast<long long>(end);
+    }
+};
+
+} // namespace vrp
@@ -0,0 +1,627 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace vrp
+{
+
+// One candidate trip of a set-partitioning model: the rows (customers) it covers and its cost.
+struct Column
+{
+    std::vector<int> rows;
+    long long cost = 0;
+};
+
+// Budget of SetPartitioningSolver::solve(); 0 means no limit. When the time or node budget runs
+// out, the search stops with its incumbent and the lower bound proven so far.
+struct SetPartitioningLimits
+{
+    double timeLimitMillis = 0;
+    long long nodeLimit = 0;
+    long long diveInterval = 1000; // nodes between dives from the best open node, 0 for none
+};
+
+// Exact set partitioning over a fixed column pool: choose columns covering every row exactly
+// once at minimum cost. Each branch-and-bound node solves the LP relaxation by column
+// generation. The restricted master starts from one artificial column per row plus the
+// parent's columns that are still allowed, and is solved by a revised simplex with a dense
+// basis inverse; the pool is priced against its duals and the most negative columns are added
+// until none is left. Branching is Ryan-Foster: for two rows covered together by a fractional
+// amount, one side only allows columns containing both or neither, the other only columns
+// that do not contain both. Unlike fixing single columns, both sides cut the LP optimum off.
+// Nodes are explored best-first after one dive for an incumbent; further dives start from the
+// best open node every few nodes, and an incumbent found elsewhere can be offered up front.
+class SetPartitioningSolver
+{
+private:
+    static constexpr double EPS = 1e-9;
+    static constexpr int REFACTOR_INTERVAL = 100;
+    static constexpr int DEGENERATE_LIMIT = 50; // then Bland's rule, which cannot cycle
+
+    // Rows a and b must be covered by the same column, or must not.
+    struct Decision
+    {
+        int a;
+        int b;
+        bool together;
+    };
+
+    struct Node
+    {
+        double bound; // of the parent, a lower bound for the node
+        std::vector<Decision> decisions;
+
+        bool operator>(const Node &other) const
+        {
+            return bound > other.bound || (bound == other.bound && decisions.size() < other.decisions.size());
+        }
+    };
+
+    struct MasterColumn
+    {
+        int pool; // -1 for the artificial column of `row`
+        int row;
+    };
+
+    int numberOfRows;
+    std::vector<Column> pool;
+    double artificialCost = 1;
+
+    // Decisions of the node being solved, per row.
+    std::vector<std::vector<int>> together;
+    std::vector<std::vector<int>> apart;
+    std::vector<int> bestColumns;
+    long long bestCost = LLONG_MAX;
+
+    // Restricted master of the current node.
+    int m = 0;
+    std::vector<MasterColumn> master;
+    std::vector<char> inMaster;
+    std::vector<char> isBasic;
+    std::vector<int> basis; // row -> position in master
+    std::vector<double> inverse;
+    std::vector<double> values;
+    std::vector<double> duals;
+    std::vector<double> direction;
+    int pivotsSinceRefactor = 0;
+
+    SetPartitioningLimits limits;
+    std::chrono::steady_clock::time_point deadline;
+
+public:
+    long long nodes = 0;
+    long long pivots = 0;
+    long long columnsPriced = 0;
+    long long lowerBound = 0; // proven by solve(); equals the returned cost when optimal
+    bool optimal = false;
+
+    SetPartitioningSolver(int rows, std::vector<Column> columns)
+        : numberOfRows(rows), pool(std::move(columns)), together(rows), apart(rows), m(rows), inMaster(pool.size(), 0)
+    {
+        long long maxCost = 0;
+        for (const Column &column : pool)
+        {
+            maxCost = std::max(maxCost, column.cost);
+        }
+        // Dearer than any cover, so artificials only stay basic when the node is infeasible.
+        artificialCost = (static_cast<double>(maxCost) + 1) * (rows + 1);
+    }
+
+    // Starts the search from a known partition, e.g. a heuristic solution, so that pruning
+    // works from the first node. Returns false, and changes nothing, if the columns do not
+    // cover every row exactly once or are not cheaper than the incumbent.
+    bool offerIncumbent(const std::vector<int> &columns)
+    {
+        std::vector<int> covered(numberOfRows, 0);
+        long long cost = 0;
+        for (int column : columns)
+        {
+            for (int row : pool[column].rows)
+            {
+                ++covered[row];
+            }
+            cost += pool[column].cost;
+        }
+        if (std::count(covered.begin(), covered.end(), 1) != numberOfRows || cost >= bestCost)
+        {
+            return false;
+        }
+        bestCost = cost;
+        bestColumns = columns;
+        return true;
+    }
+
+    // Returns the cheapest partition found, or LLONG_MAX when there is none. Without limits it
+    // is optimal; otherwise optimal and lowerBound say how far from it the search got.
+    long long solve(const SetPartitioningLimits &budget = SetPartitioningLimits())
+    {
+        limits = budget;
+        deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(static_cast<long long>(limits.timeLimitMillis * 1000));
+        if (numberOfRows == 0)
+        {
+            bestCost = 0;
+            lowerBound = 0;
+            optimal = true;
+            return bestCost;
+        }
+        dive({});
+
+        // Best-first: the open node with the lowest parent bound is solved next, so the search
+        // stops as soon as no open node can beat the incumbent.
+        std::priority_queue<Node, std::vector<Node>, std::greater<Node>> open;
+        open.push({0, {}});
+        double bound;
+        std::vector<std::pair<int, double>> positive;
+        long long lastDive = nodes;
+        while (!open.empty() && !prunable(open.top().bound) && !outOfBudget())
+        {
+            if (limits.diveInterval > 0 && nodes - lastDive >= limits.diveInterval)
+            {
+                dive(open.top().decisions);
+                lastDive = nodes;
+                continue;
+            }
+            Node node = open.top();
+            open.pop();
+            apply(node.decisions);
+            std::pair<int, int> split;
+            double shared;
+            if (evaluate(bound, positive, split, shared))
+            {
+                for (bool side : {shared >= 0.5, shared < 0.5})
+                {
+                    Node child{bound, node.decisions};
+                    child.decisions.push_back({split.first, split.second, side});
+                    open.push(std::move(child));
+                }
+            }
+            undo(node.decisions);
+        }
+
+        optimal = open.empty() || prunable(open.top().bound);
+        lowerBound = optimal ? bestCost : std::min(bestCost, static_cast<long long>(std::ceil(open.top().bound - 1e-6)));
+        return bestCost;
+    }
+
+    // Pool indices of the optimal columns.
+    const std::vector<int> &solution() const
+    {
+        return bestColumns;
+    }
+
+private:
+    bool prunable(double bound) const
+    {
+        return static_cast<long long>(std::ceil(bound - 1e-6)) >= bestCost;
+    }
+
+    bool outOfBudget() const
+    {
+        return (limits.nodeLimit > 0 && nodes >= limits.nodeLimit) ||
+               (limits.timeLimitMillis > 0 && std::chrono::steady_clock::now() >= deadline);
+    }
+
+    // Solves the node's relaxation and records integral solutions. Returns true when the node
+    // has to be split, with the most fractional pair of rows covered by the same columns.
+    bool evaluate(double &bound, std::vector<std::pair<int, double>> &positive, std::pair<int, int> &split, double &shared)
+    {
+        ++nodes;
+        if (!solveRelaxation(bound, positive) || prunable(bound))
+        {
+            return false;
+        }
+
+        std::map<std::pair<int, int>, double> pairs;
+        bool integral = true;
+        for (const auto &[column, value] : positive)
+        {
+            if (value >= 1 - 1e-6)
+            {
+                continue;
+            }
+            integral = false;
+            const std::vector<int> &rows = pool[column].rows;
+            for (size_t i = 0; i < rows.size(); ++i)
+            {
+                for (size_t j = i + 1; j < rows.size(); ++j)
+                {
+                    pairs[{rows[i], rows[j]}] += value;
+                }
+            }
+        }
+        if (integral)
+        {
+            bestCost = 0;
+            bestColumns.clear();
+            for (const auto &entry : positive)
+            {
+                bestCost += pool[entry.first].cost;
+                bestColumns.push_back(entry.first);
+            }
+            return false;
+        }
+
+        // One always exists when the solution is fractional, barring numerical trouble.
+        split = {-1, -1};
+        for (const auto &[rows, value] : pairs)
+        {
+            if (value < 1 - 1e-6 && (split.first == -1 || std::abs(value - 0.5) < std::abs(shared - 0.5)))
+            {
+                split = rows;
+                shared = value;
+            }
+        }
+        return split.first != -1;
+    }
+
+    // Follows the likelier side of every split from the given node down to an integral
+    // solution or a dead end, which usually gives a good incumbent before the best-first search
+    // starts, and a better one when it starts from the best open node later.
+    void dive(std::vector<Decision> decisions)
+    {
+        apply(decisions);
+        double bound;
+        std::vector<std::pair<int, double>> positive;
+        std::pair<int, int> split;
+        double shared;
+        while (!outOfBudget() && evaluate(bound, positive, split, shared))
+        {
+            decisions.push_back({split.first, split.second, shared >= 0.5});
+            apply({decisions.back()});
+        }
+        undo(decisions);
+    }
+
+    void apply(const std::vector<Decision> &decisions)
+    {
+        for (const Decision &decision : decisions)
+        {
+            std::vector<std::vector<int>> &constraint = decision.together ? together : apart;
+            constraint[decision.a].push_back(decision.b);
+            constraint[decision.b].push_back(decision.a);
+        }
+    }
+
+    void undo(const std::vector<Decision> &decisions)
+    {
+        for (const Decision &decision : decisions)
+        {
+            std::vector<std::vector<int>> &constraint = decision.together ? together : apart;
+            constraint[decision.a].pop_back();
+            constraint[decision.b].pop_back();
+        }
+    }
+
+    bool eligible(int column) const
+    {
+        const std::vector<int> &rows = pool[column].rows;
+        auto contains = [&rows](int row)
+        { return std::find(rows.begin(), rows.end(), row) != rows.end(); };
+        for (int row : rows)
+        {
+            for (int other : together[row])
+            {
+                if (!contains(other))
+                {
+                    return false;
+                }
+            }
+            for (int other : apart[row])
+            {
+                if (contains(other))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    double masterCost(const MasterColumn &column) const
+    {
+        return column.pool < 0 ? artificialCost : static_cast<double>(pool[column.pool].cost);
+    }
+
+    // LP rows of a master column.
+    template <typename Visit>
+    void forEachRow(const MasterColumn &column, Visit visit) const
+    {
+        if (column.pool < 0)
+        {
+            visit(column.row);
+            return;
+        }
+        for (int row : pool[column.pool].rows)
+        {
+            visit(row);
+        }
+    }
+
+    // Column generation at the current node; false when no combination of allowed columns
+    // covers every row.
+    bool solveRelaxation(double &objective, std::vector<std::pair<int, double>> &positive)
+    {
+        std::vector<MasterColumn> inherited;
+        for (const MasterColumn &column : master)
+        {
+            if (column.pool < 0)
+            {
+                continue;
+            }
+            if (eligible(column.pool))
+            {
+                inherited.push_back(column);
+            }
+            else
+            {
+                inMaster[column.pool] = 0;
+            }
+        }
+        master.clear();
+        basis.resize(m);
+        for (int row = 0; row < m; ++row)
+        {
+            master.push_back({-1, row});
+            basis[row] = row;
+        }
+        master.insert(master.end(), inherited.begin(), inherited.end());
+        isBasic.assign(master.size(), 0);
+        std::fill(isBasic.begin(), isBasic.begin() + m, 1);
+        inverse.assign(static_cast<size_t>(m) * m, 0);
+        for (int row = 0; row < m; ++row)
+        {
+            inverse[static_cast<size_t>(row) * m + row] = 1;
+        }
+        values.assign(m, 1);
+        pivotsSinceRefactor = 0;
+
+        std::vector<std::pair<double, int>> candidates;
+        while (true)
+        {
+            runSimplex();
+            computeDuals();
+            candidates.clear();
+            for (size_t column = 0; column < pool.size(); ++column)
+            {
+                if (inMaster[column] || !eligible(column))
+                {
+                    continue;
+                }
+                double reduced = static_cast<double>(pool[column].cost);
+                for (int row : pool[column].rows)
+                {
+                    reduced -= duals[row];
+                }
+                if (reduced < -EPS)
+                {
+                    candidates.push_back({reduced, static_cast<int>(column)});
+                }
+            }
+            columnsPriced += pool.size();
+            if (candidates.empty())
+            {
+                break;
+            }
+            size_t added = std::min<size_t>(candidates.size(), std::max(m, 8));
+            std::partial_sort(candidates.begin(), candidates.begin() + added, candidates.end());
+            for (size_t i = 0; i < added; ++i)
+            {
+                master.push_back({candidates[i].second, -1});
+                isBasic.push_back(0);
+                inMaster[candidates[i].second] = 1;
+            }
+        }
+
+        objective = 0;
+        positive.clear();
+        for (int row = 0; row < m; ++row)
+        {
+            const MasterColumn &column = master[basis[row]];
+            if (values[row] <= EPS)
+            {
+                continue;
+            }
+            if (column.pool < 0)
+            {
+                return false;
+            }
+            objective += values[row] * pool[column.pool].cost;
+            positive.push_back({column.pool, values[row]});
+        }
+        return true;
+    }
+
+    void computeDuals()
+    {
+        duals.assign(m, 0);
+        for (int k = 0; k < m; ++k)
+        {
+            double cost = masterCost(master[basis[k]]);
+            const double *row = &inverse[static_cast<size_t>(k) * m];
+            for (int i = 0; i < m; ++i)
+            {
+                duals[i] += cost * row[i];
+            }
+        }
+    }
+
+    // Primal simplex over the master columns, warm-started from the current basis.
+    void runSimplex()
+    {
+        int degenerate = 0;
+        direction.resize(m);
+        while (true)
+        {
+            computeDuals();
+            int entering = -1;
+            double mostNegative = -EPS;
+            for (size_t position = 0; position < master.size(); ++position)
+            {
+                if (isBasic[position])
+                {
+                    continue;
+                }
+                double reduced = masterCost(master[position]);
+                forEachRow(master[position], [&](int row)
+                           { reduced -= duals[row]; });
+                if (reduced < mostNegative)
+                {
+                    entering = position;
+                    mostNegative = reduced;
+                    if (degenerate >= DEGENERATE_LIMIT)
+                    {
+                        break;
+                    }
+                }
+            }
+            if (entering == -1)
+            {
+                return;
+            }
+
+            for (int k = 0; k < m; ++k)
+            {
+                const double *row = &inverse[static_cast<size_t>(k) * m];
+                double sum = 0;
+                forEachRow(master[entering], [&](int i)
+                           { sum += row[i]; });
+                direction[k] = sum;
+            }
+            int leaving = -1;
+            double ratio = 0;
+            for (int k = 0; k < m; ++k)
+            {
+                if (direction[k] <= EPS)
+                {
+                    continue;
+                }
+                double candidate = values[k] / direction[k];
+                if (leaving == -1 || candidate < ratio - EPS || (candidate < ratio + EPS && basis[k] < basis[leaving]))
+                {
+                    leaving = k;
+                    ratio = candidate;
+                }
+            }
+            if (leaving == -1)
+            {
+                return; // unbounded, impossible with x <= 1 implied by the rows
+            }
+            degenerate = ratio < EPS ? degenerate + 1 : 0;
+            pivot(entering, leaving);
+        }
+    }
+
+    void pivot(int entering, int leaving)
+    {
+        double *pivotRow = &inverse[static_cast<size_t>(leaving) * m];
+        double scale = 1 / direction[leaving];
+        for (int i = 0; i < m; ++i)
+        {
+            pivotRow[i] *= scale;
+        }
+        values[leaving] *= scale;
+        for (int k = 0; k < m; ++k)
+        {
+            if (k == leaving || std::abs(direction[k]) <= EPS)
+            {
+                continue;
+            }
+            double factor = direction[k];
+            double *row = &inverse[static_cast<size_t>(k) * m];
+            for (int i = 0; i < m; ++i)
+            {
+                row[i] -= factor * pivotRow[i];
+            }
+            values[k] = std::max(0.0, values[k] - factor * values[leaving]);
+        }
+        isBasic[basis[leaving]] = 0;
+        isBasic[entering] = 1;
+        basis[leaving] = entering;
+        ++pivots;
+        if (++pivotsSinceRefactor == REFACTOR_INTERVAL)
+        {
+            refactor();
+        }
+    }
+
+    // Rebuilds the inverse and the basic values from the basis columns with Gauss-Jordan
+    // elimination, clearing the drift of the product-form updates.
+    void refactor()
+    {
+        pivotsSinceRefactor = 0;
+        std::vector<double> matrix(static_cast<size_t>(m) * m, 0);
+        for (int k = 0; k < m; ++k)
+        {
+            forEachRow(master[basis[k]], [&](int row)
+                       { matrix[static_cast<size_t>(row) * m + k] = 1; });
+        }
+        // Built aside and swapped in on success, so a singular basis leaves the inverse kept up
+        // to date by the pivots untouched.
+        std::vector<double> fresh(static_cast<size_t>(m) * m, 0);
+        for (int k = 0; k < m; ++k)
+        {
+            fresh[static_cast<size_t>(k) * m + k] = 1;
+        }
+        for (int column = 0; column < m; ++column)
+        {
+            int pivotRow = column;
+            for (int row = column + 1; row < m; ++row)
+            {
+                if (std::abs(matrix[static_cast<size_t>(row) * m + column]) > std::abs(matrix[static_cast<size_t>(pivotRow) * m + column]))
+                {
+                    pivotRow = row;
+                }
+            }
+            if (std::abs(matrix[static_cast<size_t>(pivotRow) * m + column]) <= EPS)
+            {
+                return; // numerically singular; keep the updated inverse
+            }
+            if (pivotRow != column)
+            {
+                std::swap_ranges(matrix.begin() + static_cast<size_t>(pivotRow) * m, matrix.begin() + static_cast<size_t>(pivotRow + 1) * m,
+                                 matrix.begin() + static_cast<size_t>(column) * m);
+                std::swap_ranges(fresh.begin() + static_cast<size_t>(pivotRow) * m, fresh.begin() + static_cast<size_t>(pivotRow + 1) * m,
+                                 fresh.begin() + static_cast<size_t>(column) * m);
+            }
+            double scale = 1 / matrix[static_cast<size_t>(column) * m + column];
+            for (int i = 0; i < m; ++i)
+            {
+                matrix[static_cast<size_t>(column) * m + i] *= scale;
+                fresh[static_cast<size_t>(column) * m + i] *= scale;
+            }
+            for (int row = 0; row < m; ++row)
+            {
+                double factor = matrix[static_cast<size_t>(row) * m + column];
+                if (row == column || factor == 0)
+                {
+                    continue;
+                }
+                for (int i = 0; i < m; ++i)
+                {
+                    matrix[static_cast<size_t>(row) * m + i] -= factor * matrix[static_cast<size_t>(column) * m + i];
+                    fresh[static_cast<size_t>(row) * m + i] -= factor * fresh[static_cast<size_t>(column) * m + i];
+                }
+            }
+        }
+        inverse.swap(fresh);
+        for (int k = 0; k < m; ++k)
+        {
+            double sum = 0;
+            for (int i = 0; i < m; ++i)
+            {
+                sum += inverse[static_cast<size_t>(k) * m + i];
+            }
+            values[k] = std::max(0.0, sum);
+        }
+    }
+};
+
+} // namespace vrp
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "vrp_solver.hpp"
+
+namespace vrp
+{
+
+// All-pairs shortest paths over the road network: a dense metric-closure matrix plus a next-hop
+// matrix for path reconstruction. Sparse graphs run one Dijkstra per source, dense graphs use a
+// cache-blocked Floyd-Warshall; both run on OpenMP threads in engines built with -fopenmp and
+// serially otherwise.
+class ShortestPaths
+{
+public:
+    static constexpr int NO_PATH = INT_MAX;
+    static constexpr int BLOCK = 64;
+
+private:
+    int numberOfCities = 0;
+    std::vector<int> distances;
+    std::vector<int> nextHop;
+    bool floydWarshall = false;
+
+public:
+    void compute(int cities, const std::vector<Edge> &roads)
+    {
+        numberOfCities = cities;
+        size_t cells = static_cast<size_t>(cities) * cities;
+        // Dijkstra is O(n m log n) against Floyd-Warshall's O(n^3); past ~n^2/8 roads the
+        // blocked Floyd-Warshall wins through its cache behaviour.
+        floydWarshall = roads.size() * 8 > cells;
+        if (floydWarshall)
+        {
+            computeFloydWarshall(roads);
+        }
+        else
+        {
+            computeDijkstra(roads);
+        }
+    }
+
+    bool usedFloydWarshall() const
+    {
+        return floydWarshall;
+    }
+
+    int distance(int from, int to) const
+    {
+        return distances[static_cast<size_t>(from) * numberOfCities + to];
+    }
+
+    const std::vector<int> &matrix() const
+    {
+        return distances;
+    }
+
+    // Appends the cities after `from` on the shortest path to `to`, ending with `to`.
+    void appendPath(int from, int to, std::vector<int> &out) const
+    {
+        while (from != to)
+        {
+            from = nextHop[static_cast<size_t>(from) * numberOfCities + to];
+            if (from < 0)
+            {
+                return;
+            }
+            out.push_back(from);
+        }
+    }
+
+    // Replaces every leg of a route by the road-level path it stands for.
+    std::vector<int> expand(const std::vector<int> &route) const
+    {
+        std::vector<int> expanded;
+        if (route.empty())
+        {
+            return expanded;
+        }
+        expanded.push_back(route[0]);
+        for (size_t i = 0; i + 1 < route.size(); ++i)
+        {
+            appendPath(route[i], route[i + 1], expanded);
+        }
+        return expanded;
+    }
+
+    // Every reachable pair as a direct road of the closure.
+    std::vector<Edge> closureRoads() const
+    {
+        std::vector<Edge> roads;
+        for (int from = 0; from < numberOfCities; ++from)
+        {
+            for (int to = 0; to < numberOfCities; ++to)
+            {
+                if (from != to && distance(from, to) != NO_PATH)
+                {
+                    roads.push_back({from, to, distance(from, to)});
+                }
+            }
+        }
+        return roads;
+    }
+
+private:
+    void computeDijkstra(const std::vector<Edge> &roads)
+    {
+        int n = numberOfCities;
+        std::vector<int> offsets(n + 1, 0);
+        for (const Edge &road : roads)
+        {
+            offsets[road.start + 1]++;
+        }
+        for (int i = 0; i < n; ++i)
+        {
+            offsets[i + 1] += offsets[i];
+        }
+        std::vector<std::pair<int, int>> adjacency(roads.size());
+        std::vector<int> fill(offsets.begin(), offsets.end() - 1);
+        for (const Edge &road : roads)
+        {
+            adjacency[fill[road.start]++] = {road.destination, road.cost};
+        }
+
+        distances.assign(static_cast<size_t>(n) * n, NO_PATH);
+        nextHop.assign(static_cast<size_t>(n) * n, -1);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for (int source = 0; source < n; ++source)
+        {
+            int *distance = &distances[static_cast<size_t>(source) * n];
+            int *next = &nextHop[static_cast<size_t>(source) * n];
+            using Entry = std::pair<long long, int>;
+            std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+            distance[source] = 0;
+            next[source] = source;
+            queue.push({0, source});
+            while (!queue.empty())
+            {
+                auto [length, city] = queue.top();
+                queue.pop();
+                if (length > distance[city])
+                {
+                    continue;
+                }
+                for (int i = offsets[city]; i < offsets[city + 1]; ++i)
+                {
+                    auto [neighbor, cost] = adjacency[i];
+                    long long candidate = length + cost;
+                    if (candidate < distance[neighbor])
+                    {
+                        distance[neighbor] = static_cast<int>(candidate);
+                        // The first hop out of the source is inherited along the tree.
+                        next[neighbor] = city == source ? neighbor : next[city];
+                        queue.push({candidate, neighbor});
+                    }
+                }
+            }
+        }
+    }
+
+    // Blocked Floyd-Warshall: for every diagonal tile k, relax the tile itself, then its row and
+    // column of tiles, then all remaining tiles in parallel. Each phase works on 64x64 tiles
+    // that stay in cache.
+    void computeFloydWarshall(const std::vector<Edge> &roads)
+    {
+        int n = numberOfCities;
+        distances.assign(static_cast<size_t>(n) * n, NO_PATH);
+        nextHop.assign(static_cast<size_t>(n) * n, -1);
+        for (int city = 0; city < n; ++city)
+        {
+            distances[static_cast<size_t>(city) * n + city] = 0;
+            nextHop[static_cast<size_t>(city) * n + city] = city;
+        }
+        for (const Edge &road : roads)
+        {
+            size_t cell = static_cast<size_t>(road.start) * n + road.destination;
+            if (road.start != road.destination && road.cost < distances[cell])
+            {
+                distances[cell] = road.cost;
+                nextHop[cell] = road.destination;
+            }
+        }
+
+        int tiles = (n + BLOCK - 1) / BLOCK;
+        for (int k = 0; k < tiles; ++k)
+        {
+            relaxTile(k, k, k);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+            for (int t = 0; t < tiles; ++t)
+            {
+                if (t != k)
+                {
+                    relaxTile(k, t, k);
+                    relaxTile(t, k, k);
+                }
+            }
+
+#ifdef _OPENMP
+#pragma omp parallel for collapse(2) schedule(dynamic)
+#endif
+            for (int i = 0; i < tiles; ++i)
+            {
+                for (int j = 0; j < tiles; ++j)
+                {
+                    if (i != k && j != k)
+                    {
+                        relaxTile(i, j, k);
+                    }
+                }
+            }
+        }
+    }
+
+    void relaxTile(int tileRow, int tileColumn, int tileK)
+    {
+        int n = numberOfCities;
+        int kEnd = std::min(n, (tileK + 1) * BLOCK);
+        int iEnd = std::min(n, (tileRow + 1) * BLOCK);
+        int jBegin = tileColumn * BLOCK;
+        int jEnd = std::min(n, (tileColumn + 1) * BLOCK);
+        for (int k = tileK * BLOCK; k < kEnd; ++k)
+        {
+            const int *rowK = &distances[static_cast<size_t>(k) * n];
+            for (int i = tileRow * BLOCK; i < iEnd; ++i)
+            {
+                int *rowI = &distances[static_cast<size_t>(i) * n];
+                int viaK = rowI[k];
+                if (viaK == NO_PATH)
+                {
+                    continue;
+                }
+                int *nextI = &nextHop[static_cast<size_t>(i) * n];
+                int hop = nextI[k];
+                for (int j = jBegin; j < jEnd; ++j)
+                {
+                    // Summed in 64 bits: two lengths just below NO_PATH would overflow an int.
+                    long long through = static_cast<long long>(viaK) + rowK[j];
+                    if (rowK[j] != NO_PATH && through < rowI[j])
+                    {
+                        rowI[j] = static_cast<int>(through);
+                        nextI[j] = hop;
+                    }
+                }
+            }
+        }
+    }
+};
+
+} // namespace vrp
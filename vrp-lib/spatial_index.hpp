@@ -0,0 +1,205 @@
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace vrp
+{
+
+// Rounded Euclidean distance, the cost of a road between two coordinate-based cities.
+inline int euclideanCost(double x1, double y1, double x2, double y2)
+{
+    return static_cast<int>(std::lround(std::hypot(x1 - x2, y1 - y2)));
+}
+
+// Static 2-d tree over city coordinates with deletions. Every node also keeps the smallest
+// package weight still present in its subtree, so "nearest city that fits in the vehicle"
+// skips whole subtrees of cities that are too heavy or already visited.
+class SpatialIndex
+{
+private:
+    struct Node
+    {
+        int city;
+        int left = -1;
+        int right = -1;
+        int parent = -1;
+        int axis = 0;
+        int minWeight; // INT_MAX once every city below has been removed
+    };
+
+    std::vector<double> xs;
+    std::vector<double> ys;
+    std::vector<int> weights;
+    std::vector<Node> nodes;
+    std::vector<int> nodeOf;
+    std::vector<char> present;
+    int root = -1;
+
+public:
+    // Indexes cities [first, xs.size()); cities before `first` (the depot) are never returned.
+    SpatialIndex(const std::vector<double> &x, const std::vector<double> &y, const std::vector<int> &packageWeights, int first = 1)
+        : xs(x), ys(y), weights(packageWeights), nodeOf(x.size(), -1), present(x.size(), 0)
+    {
+        std::vector<int> order;
+        order.reserve(xs.size());
+        for (int city = first; city < static_cast<int>(xs.size()); ++city)
+        {
+            order.push_back(city);
+            present[city] = 1;
+        }
+        nodes.reserve(order.size());
+        root = build(order, 0, order.size(), 0, -1);
+    }
+
+    bool contains(int city) const
+    {
+        return present[city];
+    }
+
+    void remove(int city)
+    {
+        if (!present[city])
+        {
+            return;
+        }
+        present[city] = 0;
+        for (int node = nodeOf[city]; node != -1; node = nodes[node].parent)
+        {
+            int updated = subtreeMin(node);
+            if (updated == nodes[node].minWeight)
+            {
+                break;
+            }
+            nodes[node].minWeight = updated;
+        }
+    }
+
+    // Nearest remaining city to (x, y) with weight <= maxWeight, or -1.
+    int nearest(double x, double y, int maxWeight) const
+    {
+        int best = -1;
+        double bestDistance = INFINITY;
+        searchNearest(root, x, y, maxWeight, best, bestDistance);
+        return best;
+    }
+
+    // The k nearest remaining cities to `city`, closest first; used for candidate neighbour lists.
+    std::vector<int> kNearest(int city, int k) const
+    {
+        std::vector<std::pair<double, int>> heap;
+        heap.reserve(k + 1);
+        searchKNearest(root, xs[city], ys[city], city, k, heap);
+        std::sort_heap(heap.begin(), heap.end());
+        std::vector<int> result;
+        result.reserve(heap.size());
+        for (const auto &entry : heap)
+        {
+            result.push_back(entry.second);
+        }
+        return result;
+    }
+
+private:
+    int build(std::vector<int> &order, size_t begin, size_t end, int depth, int parent)
+    {
+        if (begin >= end)
+        {
+            return -1;
+        }
+        int axis = depth % 2;
+        size_t middle = begin + (end - begin) / 2;
+        std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end, [this, axis](int a, int b)
+                         { return axis == 0 ? xs[a] < xs[b] : ys[a] < ys[b]; });
+
+        int node = nodes.size();
+        nodes.push_back(Node{order[middle], -1, -1, parent, axis, weights[order[middle]]});
+        nodeOf[order[middle]] = node;
+        int left = build(order, begin, middle, depth + 1, node);
+        int right = build(order, middle + 1, end, depth + 1, node);
+        nodes[node].left = left;
+        nodes[node].right = right;
+        nodes[node].minWeight = subtreeMin(node);
+        return node;
+    }
+
+    int subtreeMin(int node) const
+    {
+        const Node &current = nodes[node];
+        int result = present[current.city] ? weights[current.city] : INT_MAX;
+        if (current.left != -1)
+        {
+            result = std::min(result, nodes[current.left].minWeight);
+        }
+        if (current.right != -1)
+        {
+            result = std::min(result, nodes[current.right].minWeight);
+        }
+        return result;
+    }
+
+    void searchNearest(int node, double x, double y, int maxWeight, int &best, double &bestDistance) const
+    {
+        if (node == -1 || nodes[node].minWeight > maxWeight)
+        {
+            return;
+        }
+        const Node &current = nodes[node];
+        int city = current.city;
+        if (present[city] && weights[city] <= maxWeight)
+        {
+            double distance = (xs[city] - x) * (xs[city] - x) + (ys[city] - y) * (ys[city] - y);
+            if (distance < bestDistance || (distance == bestDistance && city < best))
+            {
+                bestDistance = distance;
+                best = city;
+            }
+        }
+        double offset = current.axis == 0 ? x - xs[city] : y - ys[city];
+        int nearSide = offset < 0 ? current.left : current.right;
+        int farSide = offset < 0 ? current.right : current.left;
+        searchNearest(nearSide, x, y, maxWeight, best, bestDistance);
+        if (offset * offset <= bestDistance)
+        {
+            searchNearest(farSide, x, y, maxWeight, best, bestDistance);
+        }
+    }
+
+    void searchKNearest(int node, double x, double y, int exclude, int k, std::vector<std::pair<double, int>> &heap) const
+    {
+        if (node == -1 || nodes[node].minWeight == INT_MAX)
+        {
+            return;
+        }
+        const Node &current = nodes[node];
+        int city = current.city;
+        if (present[city] && city != exclude)
+        {
+            double distance = (xs[city] - x) * (xs[city] - x) + (ys[city] - y) * (ys[city] - y);
+            if (static_cast<int>(heap.size()) < k)
+            {
+                heap.emplace_back(distance, city);
+                std::push_heap(heap.begin(), heap.end());
+            }
+            else if (distance < heap.front().first)
+            {
+                std::pop_heap(heap.begin(), heap.end());
+                heap.back() = {distance, city};
+                std::push_heap(heap.begin(), heap.end());
+            }
+        }
+        double offset = current.axis == 0 ? x - xs[city] : y - ys[city];
+        int nearSide = offset < 0 ? current.left : current.right;
+        int farSide = offset < 0 ? current.right : current.left;
+        searchKNearest(nearSide, x, y, exclude, k, heap);
+        if (static_cast<int>(heap.size()) < k || offset * offset <= heap.front().first)
+        {
+            searchKNearest(farSide, x, y, exclude, k, heap);
+        }
+    }
+};
+
+} // namespace vrp
@@ -0,0 +1,315 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <climits>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+namespace vrp
+{
+
+// Counters owned by one worker thread, on a cache line of their own so that counting never
+// bounces a line between cores. Only the owner writes them, so an increment is a relaxed load
+// and store rather than a locked read-modify-write; the reporter reads them with relaxed loads.
+struct alignas(64) ThreadTelemetry
+{
+    std::atomic<long long> nodes{0};  // search nodes expanded
+    std::atomic<long long> routes{0}; // complete routes filtered or priced
+    std::atomic<bool> busy{false};    // inside a phase's work rather than waiting at a barrier
+
+    void addNodes(long long count)
+    {
+        nodes.store(nodes.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+    }
+
+    void addRoutes(long long count)
+    {
+        routes.store(routes.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+    }
+
+    void setBusy(bool value)
+    {
+        busy.store(value, std::memory_order_relaxed);
+    }
+};
+
+// Progress of a long search, sampled by a background thread and written as one JSON object per
+// line to a file or a Unix-domain stream socket, so a dashboard can tail it while the job runs:
+//   {"rank":0,"seconds":12.0,"phase":"evaluate","nodes":...,"nodesPerSecond":...,"routes":...,
+//    "routesPerSecond":...,"frontier":...,"incumbent":...,"lowerBound":...,"gap":...,
+//    "utilization":[0.98,0.97,...]}
+// rates cover the last interval; utilization is the share of it each thread spent busy,
+// estimated from its busy flag sampled every few milliseconds. The counters are always there;
+// the reporter thread only runs between start() and stop().
+class Telemetry
+{
+private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr int SAMPLE_MILLIS = 5;
+
+    std::vector<ThreadTelemetry> threads;
+    std::atomic<const char *> phase{"start"};
+    std::atomic<long long> frontier{0};
+    std::atomic<long long> incumbent{LLONG_MAX};
+    std::atomic<long long> lowerBound{0};
+
+    std::thread reporter;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    FILE *file = nullptr;
+    int socketFd = -1;
+    std::string unsent; // tail of a line the socket did not take yet
+    int rank = -1;
+
+public:
+    explicit Telemetry(int threadCount) : threads(threadCount)
+    {
+    }
+
+    ~Telemetry()
+    {
+        stop();
+    }
+
+    ThreadTelemetry &thread(int index)
+    {
+        return threads[index];
+    }
+
+    long long nodes() const
+    {
+        return sum(&ThreadTelemetry::nodes);
+    }
+
+    long long routes() const
+    {
+        return sum(&ThreadTelemetry::routes);
+    }
+
+    // phase must be a string literal.
+    void setPhase(const char *name)
+    {
+        phase.store(name, std::memory_order_relaxed);
+    }
+
+    // Pending entries of the search stack.
+    void setFrontier(size_t size)
+    {
+        frontier.store(static_cast<long long>(size), std::memory_order_relaxed);
+    }
+
+    // Keeps the cheapest cost offered; callers only offer improvements, which are rare.
+    void offerIncumbent(long long cost)
+    {
+        long long current = incumbent.load(std::memory_order_relaxed);
+        while (cost < current && !incumbent.compare_exchange_weak(current, cost, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void setLowerBound(long long bound)
+    {
+        lowerBound.store(bound, std::memory_order_relaxed);
+    }
+
+    // target is a file, appended to, or unix:<path> for a listening Unix-domain stream socket.
+    // rank is written into every line when it is not negative.
+    void start(const std::string &target, int intervalMillis, int rankNumber = -1)
+    {
+        rank = rankNumber;
+        if (target.rfind("unix:", 0) == 0)
+        {
+            socketFd = connectTo(target.substr(5));
+        }
+        else
+        {
+            file = std::fopen(target.c_str(), "a");
+            if (!file)
+            {
+                throw std::runtime_error("Failed to open telemetry file " + target + ".");
+            }
+        }
+        reporter = std::thread([this, intervalMillis]
+                               { report(std::max(intervalMillis, SAMPLE_MILLIS)); });
+    }
+
+    // Writes a last line and joins the reporter.
+    void stop()
+    {
+        if (!reporter.joinable())
+        {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        reporter.join();
+        if (file)
+        {
+            std::fclose(file);
+            file = nullptr;
+        }
+        if (socketFd >= 0)
+        {
+            close(socketFd);
+            socketFd = -1;
+        }
+    }
+
+private:
+    long long sum(std::atomic<long long> ThreadTelemetry::*counter) const
+    {
+        long long total = 0;
+        for (const ThreadTelemetry &slot : threads)
+        {
+            total += (slot.*counter).load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    static int connectTo(const std::string &path)
+    {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Failed to create socket.");
+        }
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path))
+        {
+            close(fd);
+            throw std::runtime_error("Socket path is too long.");
+        }
+        std::copy(path.begin(), path.end(), address.sun_path);
+        if (connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0)
+        {
+            close(fd);
+            throw std::runtime_error("Failed to connect to telemetry socket " + path + ".");
+        }
+        return fd;
+    }
+
+    void report(int intervalMillis)
+    {
+        Clock::time_point begin = Clock::now();
+        Clock::time_point last = begin;
+        long long lastNodes = 0;
+        long long lastRoutes = 0;
+        std::vector<int> busySamples(threads.size(), 0);
+        int samples = 0;
+        bool done = false;
+        while (!done)
+        {
+            Clock::time_point next = last + std::chrono::milliseconds(intervalMillis);
+            while (!done && Clock::now() < next)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    done = wake.wait_for(lock, std::chrono::milliseconds(SAMPLE_MILLIS), [this]
+                                         { return stopping; });
+                }
+                for (size_t t = 0; t < threads.size(); ++t)
+                {
+                    busySamples[t] += threads[t].busy.load(std::memory_order_relaxed);
+                }
+                ++samples;
+            }
+
+            Clock::time_point now = Clock::now();
+            double seconds = std::chrono::duration<double>(now - last).count();
+            long long nodesNow = nodes();
+            long long routesNow = routes();
+            long long best = incumbent.load(std::memory_order_relaxed);
+            long long bound = lowerBound.load(std::memory_order_relaxed);
+
+            std::string line = "{";
+            if (rank >= 0)
+            {
+                line += "\"rank\":" + std::to_string(rank) + ",";
+            }
+            line += "\"seconds\":" + number(std::chrono::duration<double>(now - begin).count());
+            line += ",\"phase\":\"" + std::string(phase.load(std::memory_order_relaxed)) + "\"";
+            line += ",\"nodes\":" + std::to_string(nodesNow);
+            line += ",\"nodesPerSecond\":" + number(seconds > 0 ? (nodesNow - lastNodes) / seconds : 0);
+            line += ",\"routes\":" + std::to_string(routesNow);
+            line += ",\"routesPerSecond\":" + number(seconds > 0 ? (routesNow - lastRoutes) / seconds : 0);
+            line += ",\"frontier\":" + std::to_string(frontier.load(std::memory_order_relaxed));
+            line += ",\"incumbent\":" + (best == LLONG_MAX ? std::string("null") : std::to_string(best));
+            line += ",\"lowerBound\":" + std::to_string(bound);
+            line += ",\"gap\":" + (best == LLONG_MAX || best <= 0 ? std::string("null") : number(static_cast<double>(best - bound) / best));
+            line += ",\"utilization\":[";
+            for (size_t t = 0; t < threads.size(); ++t)
+            {
+                line += (t > 0 ? "," : "") + number(samples > 0 ? static_cast<double>(busySamples[t]) / samples : 0);
+            }
+            line += "]}\n";
+            write(line);
+
+            last = now;
+            lastNodes = nodesNow;
+            lastRoutes = routesNow;
+            std::fill(busySamples.begin(), busySamples.end(), 0);
+            samples = 0;
+        }
+    }
+
+    static std::string number(double value)
+    {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.3f", value);
+        return buffer;
+    }
+
+    // A dashboard that goes away only ends the telemetry, never the search, and one that reads
+    // slowly only loses samples: sends never block. A line the socket took only part of is
+    // finished before the next one, and samples taken meanwhile are dropped.
+    void write(const std::string &line)
+    {
+        if (file)
+        {
+            std::fputs(line.c_str(), file);
+            std::fflush(file);
+        }
+        if (socketFd < 0)
+        {
+            return;
+        }
+        if (unsent.empty())
+        {
+            unsent = line;
+        }
+        while (!unsent.empty())
+        {
+            ssize_t count = send(socketFd, unsent.data(), unsent.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (count < 0)
+            {
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+                {
+                    return;
+                }
+                close(socketFd);
+                socketFd = -1;
+                unsent.clear();
+                return;
+            }
+            unsent.erase(0, static_cast<size_t>(count));
+        }
+    }
+};
+
+} // namespace vrp
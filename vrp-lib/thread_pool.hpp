@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace vrp
+{
+
+class ThreadPool
+{
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stopping = false;
+
+public:
+    explicit ThreadPool(unsigned numberOfThreads = std::thread::hardware_concurrency())
+    {
+        if (numberOfThreads == 0)
+        {
+            numberOfThreads = 1;
+        }
+        workers.reserve(numberOfThreads);
+        for (unsigned i = 0; i < numberOfThreads; ++i)
+        {
+            workers.emplace_back([this]
+                                 { workerLoop(); });
+        }
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        condition.notify_all();
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    unsigned size() const
+    {
+        return static_cast<unsigned>(workers.size());
+    }
+
+    template <typename F>
+    auto submit(F &&task) -> std::future<decltype(task())>
+    {
+        using Result = decltype(task());
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> future = packaged->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.emplace([packaged]
+                          { (*packaged)(); });
+        }
+        condition.notify_one();
+        return future;
+    }
+
+    // Runs body(index, slot) for every index in [0, count). Each of the size() slots is
+    // owned by exactly one task at a time, so callers can keep per-slot scratch state.
+    template <typename F>
+    void parallelFor(size_t count, F &&body)
+    {
+        std::atomic<size_t> next{0};
+        std::vector<std::future<void>> pending;
+        pending.reserve(workers.size());
+        for (unsigned slot = 0; slot < workers.size(); ++slot)
+        {
+            pending.push_back(submit([&, slot]
+                                     {
+                for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < count; i = next.fetch_add(1, std::memory_order_relaxed))
+                {
+                    body(i, slot);
+                } }));
+        }
+        for (auto &future : pending)
+        {
+            future.get();
+        }
+    }
+
+private:
+    void workerLoop()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [this]
+                               { return stopping || !tasks.empty(); });
+                if (stopping && tasks.empty())
+                {
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+            task();
+        }
+    }
+};
+
+} // namespace vrp
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <istream>
+#include <sstream>
+#include <string>
+
+namespace vrp
+{
+
+constexpr long long TIME_HORIZON = 1LL << 40;
+
+// Service at a city may start within [ready, due] and takes `service` time units. Travel time
+// between two cities equals the road cost, and every trip leaves the depot at time 0.
+struct TimeWindow
+{
+    long long ready = 0;
+    long long due = TIME_HORIZON;
+    long long service = 0;
+};
+
+// Reads one "number weight [ready due service]" city line. Returns true when the line carried a
+// time window, so plain inputs are detected without a format flag.
+inline bool readCityLine(std::istream &file, int &number, int &packageWeight, TimeWindow &window)
+{
+    std::string line;
+    std::getline(file >> std::ws, line);
+    std::istringstream fields(line);
+    fields >> number >> packageWeight;
+    TimeWindow parsed;
+    if (fields >> parsed.ready >> parsed.due >> parsed.service)
+    {
+        window = parsed;
+        return true;
+    }
+    return false;
+}
+
+// Earliest service start at `city` after leaving the previous stop at `departure` and driving
+// `travel`, or -1 when the window has already closed.
+inline long long arrivalTime(const TimeWindow &window, long long departure, long long travel)
+{
+    long long start = std::max(departure + travel, window.ready);
+    return start <= window.due ? start : -1;
+}
+
+// Concatenable summary of a sequence of stops (Vidal et al. 2013): its minimum duration, the
+// earliest and latest feasible start of the first service, and the time warp needed to make
+// it fit. Joining two summaries is O(1), which gives O(1) feasibility checks for moves built
+// from cached prefix, suffix and reversed segments.
+struct TimeWindowSegment
+{
+    long long duration = 0;
+    long long timeWarp = 0;
+    long long earliest = 0;
+    long long latest = TIME_HORIZON;
+    int first = 0;
+    int last = 0;
+
+    static TimeWindowSegment single(int city, const TimeWindow &window)
+    {
+        return {window.service, 0, window.ready, window.due, city, city};
+    }
+
+    bool feasible() const
+    {
+        return timeWarp == 0;
+    }
+
+    template <typename TravelTime>
+    static TimeWindowSegment join(const TimeWindowSegment &a, const TimeWindowSegment &b, TravelTime travel)
+    {
+        long long delta = a.duration - a.timeWarp + travel(a.last, b.first);
+        long long waiting = std::max(b.earliest - delta - a.latest, 0LL);
+        long long warp = std::max(a.earliest + delta - b.latest, 0LL);
+        TimeWindowSegment joined;
+        joined.duration = a.duration + b.duration + travel(a.last, b.first) + waiting;
+        joined.timeWarp = a.timeWarp + b.timeWarp + warp;
+        joined.earliest = std::max(b.earliest - delta, a.earliest) - waiting;
+        joined.latest = std::min(b.latest - delta, a.latest) + warp;
+        joined.first = a.first;
+        joined.last = b.last;
+        return joined;
+    }
+};
+
+} // namespace vrp
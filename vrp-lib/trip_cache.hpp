@@ -0,0 +1,354 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace vrp
+{
+
+// Longest trip, in customers, that the cache sequences and stores.
+constexpr int MAX_TRIP_CITIES = 8;
+
+// Optimal depot-to-depot order of one customer set; cost is INT_MAX when no order has roads.
+struct CachedTrip
+{
+    int cost = INT_MAX;
+    int length = 0;
+    std::array<int, MAX_TRIP_CITIES> order{};
+};
+
+// Cheapest order of customers[0..count) from the depot and back, by Held-Karp over the subsets
+// of the trip. cost(from, to) returns INT_MAX where there is no road. Ties go to the order
+// found first, so the result depends on the order the customers are given in.
+template <typename Cost>
+CachedTrip sequenceTrip(const int *customers, int count, Cost cost)
+{
+    constexpr long long NONE = LLONG_MAX;
+    const int full = (1 << count) - 1;
+    std::vector<long long> best(static_cast<size_t>(1 << count) * count, NONE);
+    std::vector<int> previous(best.size(), -1);
+    auto at = [count](int mask, int last)
+    {
+        return static_cast<size_t>(mask) * count + last;
+    };
+
+    for (int k = 0; k < count; ++k)
+    {
+        int leg = cost(0, customers[k]);
+        if (leg != INT_MAX)
+        {
+            best[at(1 << k, k)] = leg;
+        }
+    }
+    for (int mask = 1; mask <= full; ++mask)
+    {
+        for (int last = 0; last < count; ++last)
+        {
+            long long sofar = best[at(mask, last)];
+            if (sofar == NONE)
+            {
+                continue;
+            }
+            for (int next = 0; next < count; ++next)
+            {
+                int leg = mask >> next & 1 ? INT_MAX : cost(customers[last], customers[next]);
+                if (leg == INT_MAX)
+                {
+                    continue;
+                }
+                long long &entry = best[at(mask | 1 << next, next)];
+                if (sofar + leg < entry)
+                {
+                    entry = sofar + leg;
+                    previous[at(mask | 1 << next, next)] = last;
+                }
+            }
+        }
+    }
+
+    CachedTrip trip;
+    long long total = NONE;
+    int last = -1;
+    for (int k = 0; k < count; ++k)
+    {
+        int leg = cost(customers[k], 0);
+        if (best[at(full, k)] != NONE && leg != INT_MAX && best[at(full, k)] + leg < total)
+        {
+            total = best[at(full, k)] + leg;
+            last = k;
+        }
+    }
+    if (last < 0 || total >= INT_MAX)
+    {
+        return trip;
+    }
+    trip.cost = static_cast<int>(total);
+    trip.length = count;
+    for (int mask = full, k = count; k-- > 0;)
+    {
+        trip.order[k] = customers[last];
+        int before = previous[at(mask, last)];
+        mask &= ~(1 << last);
+        last = before;
+    }
+    return trip;
+}
+
+// Optimal trip per customer set, shared by every thread of a solve. The table is open
+// addressing with a bounded probe window: a set lives in one of the WINDOW slots after its
+// hash, and a full window evicts its least recently inserted entry, so memory never grows
+// past the budget given at construction. Every slot is a 64-byte seqlock: readers never
+// block, and a writer that finds its slot busy simply skips the insert.
+//
+// Sets are keyed by a bitmask of their customers when the instance has at most 64 cities,
+// and otherwise by their sorted city numbers packed into 64 bits, which covers three-stop
+// trips up to two million cities. Sets that fit neither are not cached.
+class TripCache
+{
+private:
+    static constexpr int WINDOW = 8;
+    static constexpr int STRIPES = 64;
+
+    struct alignas(64) Slot
+    {
+        std::atomic<uint32_t> version{0}; // odd while a writer is filling the slot
+        std::atomic<uint32_t> stamp{0};
+        std::atomic<uint64_t> key{0}; // 0 when empty
+        std::atomic<int32_t> cost{0};
+        std::atomic<int32_t> length{0};
+        std::array<std::atomic<int32_t>, MAX_TRIP_CITIES> order{};
+    };
+
+    // Statistics are spread over cache lines by key, so threads rarely share a counter.
+    struct alignas(64) Counters
+    {
+        std::atomic<long long> hits{0};
+        std::atomic<long long> misses{0};
+        std::atomic<long long> evictions{0};
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    size_t mask = 0;
+    int cityBits = 0;
+    bool bitmaskKeys = false;
+    std::atomic<uint32_t> clock{0};
+    std::unique_ptr<Counters[]> counters;
+
+public:
+    static constexpr size_t DEFAULT_BYTES = 64u << 20;
+
+    // The table gets twice maxSets slots, rounded up to a power of two, unless that exceeds
+    // maxBytes; it always has at least one window. Callers pass the number of distinct sets
+    // they can meet, so small instances do not pay for a large allocation.
+    TripCache(int numberOfCities, size_t maxSets, size_t maxBytes = DEFAULT_BYTES)
+        : bitmaskKeys(numberOfCities <= 64), counters(new Counters[STRIPES])
+    {
+        while ((1 << cityBits) < numberOfCities)
+        {
+            ++cityBits;
+        }
+        size_t capacity = WINDOW;
+        while (capacity < 2 * maxSets && capacity * 2 * sizeof(Slot) <= maxBytes)
+        {
+            capacity *= 2;
+        }
+        slots.reset(new Slot[capacity]);
+        mask = capacity - 1;
+    }
+
+    bool cacheable(int count) const
+    {
+        return count > 0 && count <= MAX_TRIP_CITIES && (bitmaskKeys || count * cityBits <= 64);
+    }
+
+    // The optimal trip over customers[0..count), sequenced with cost(from, to) and stored on
+    // the first request. The caller checks cacheable(count) first.
+    template <typename Cost>
+    CachedTrip trip(const int *customers, int count, Cost cost)
+    {
+        // Sets are sequenced in ascending city order, so among equally cheap orders the stored
+        // one depends only on the set, not on which permutation or thread missed first.
+        // Insertion sort; trips are a handful of cities.
+        std::array<int, MAX_TRIP_CITIES> sorted;
+        for (int k = 0; k < count; ++k)
+        {
+            int j = k;
+            for (; j > 0 && sorted[j - 1] > customers[k]; --j)
+            {
+                sorted[j] = sorted[j - 1];
+            }
+            sorted[j] = customers[k];
+        }
+        uint64_t setKey = key(sorted.data(), count);
+        Counters &stats = counters[setKey % STRIPES];
+        CachedTrip cached;
+        if (find(setKey, cached))
+        {
+            stats.hits.fetch_add(1, std::memory_order_relaxed);
+            return cached;
+        }
+        stats.misses.fetch_add(1, std::memory_order_relaxed);
+        cached = sequenceTrip(sorted.data(), count, cost);
+        if (insert(setKey, cached))
+        {
+            stats.evictions.fetch_add(1, std::memory_order_relaxed);
+        }
+        return cached;
+    }
+
+    long long hits() const
+    {
+        return sum(&Counters::hits);
+    }
+
+    long long misses() const
+    {
+        return sum(&Counters::misses);
+    }
+
+    long long evictions() const
+    {
+        return sum(&Counters::evictions);
+    }
+
+    size_t capacity() const
+    {
+        return mask + 1;
+    }
+
+    size_t memoryBytes() const
+    {
+        return capacity() * sizeof(Slot);
+    }
+
+    // Number of sets of 1 to maxSize customers, saturating at limit.
+    static size_t customerSets(int customers, int maxSize, size_t limit = DEFAULT_BYTES)
+    {
+        size_t total = 0;
+        size_t binomial = 1;
+        for (int size = 1; size <= std::min(maxSize, customers) && total < limit; ++size)
+        {
+            binomial = binomial > limit ? limit : binomial * (customers - size + 1) / size;
+            total += binomial;
+        }
+        return std::min(total, limit);
+    }
+
+private:
+
+    // customers is sorted.
+    uint64_t key(const int *customers, int count) const
+    {
+        uint64_t setKey = 0;
+        if (bitmaskKeys)
+        {
+            for (int k = 0; k < count; ++k)
+            {
+                setKey |= uint64_t(1) << customers[k];
+            }
+            return setKey;
+        }
+        for (int k = 0; k < count; ++k)
+        {
+            setKey = setKey << cityBits | static_cast<uint64_t>(customers[k]);
+        }
+        return setKey;
+    }
+
+    static size_t hash(uint64_t setKey)
+    {
+        setKey ^= setKey >> 33;
+        setKey *= 0xff51afd7ed558ccdULL;
+        setKey ^= setKey >> 33;
+        return static_cast<size_t>(setKey);
+    }
+
+    bool find(uint64_t setKey, CachedTrip &trip) const
+    {
+        size_t home = hash(setKey);
+        for (int probe = 0; probe < WINDOW; ++probe)
+        {
+            const Slot &slot = slots[(home + probe) & mask];
+            uint32_t before = slot.version.load(std::memory_order_acquire);
+            if (before & 1 || slot.key.load(std::memory_order_relaxed) != setKey)
+            {
+                continue;
+            }
+            trip.cost = slot.cost.load(std::memory_order_relaxed);
+            trip.length = std::min<int>(slot.length.load(std::memory_order_relaxed), MAX_TRIP_CITIES);
+            for (int k = 0; k < trip.length; ++k)
+            {
+                trip.order[k] = slot.order[k].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.version.load(std::memory_order_relaxed) == before)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Returns true when an older entry was evicted to make room.
+    bool insert(uint64_t setKey, const CachedTrip &trip)
+    {
+        size_t home = hash(setKey);
+        Slot *victim = nullptr;
+        for (int probe = 0; probe < WINDOW; ++probe)
+        {
+            Slot &slot = slots[(home + probe) & mask];
+            uint64_t current = slot.key.load(std::memory_order_relaxed);
+            if (current == setKey)
+            {
+                return false; // another thread got here first
+            }
+            if (current == 0)
+            {
+                victim = &slot;
+                break;
+            }
+            // Stamps wrap, so age is measured from the clock rather than compared directly.
+            uint32_t now = clock.load(std::memory_order_relaxed);
+            if (victim == nullptr || now - slot.stamp.load(std::memory_order_relaxed) > now - victim->stamp.load(std::memory_order_relaxed))
+            {
+                victim = &slot;
+            }
+        }
+
+        uint32_t version = victim->version.load(std::memory_order_relaxed);
+        if (version & 1 || !victim->version.compare_exchange_strong(version, version + 1, std::memory_order_acquire, std::memory_order_relaxed))
+        {
+            return false;
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        bool evicted = victim->key.load(std::memory_order_relaxed) != 0;
+        victim->key.store(setKey, std::memory_order_relaxed);
+        victim->stamp.store(clock.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+        victim->cost.store(trip.cost, std::memory_order_relaxed);
+        victim->length.store(trip.length, std::memory_order_relaxed);
+        for (int k = 0; k < trip.length; ++k)
+        {
+            victim->order[k].store(trip.order[k], std::memory_order_relaxed);
+        }
+        victim->version.store(version + 2, std::memory_order_release);
+        return evicted;
+    }
+
+    long long sum(std::atomic<long long> Counters::*counter) const
+    {
+        long long total = 0;
+        for (int stripe = 0; stripe < STRIPES; ++stripe)
+        {
+            total += (counters[stripe].*counter).load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+};
+
+} // namespace vrp
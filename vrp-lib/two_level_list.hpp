@@ -0,0 +1,287 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace vrp
+{
+
+// A cyclic tour of the cities 0..n-1 stored as about sqrt(n) segments, each with its own
+// reversed bit (Fredman et al., "Data structures for traveling salesmen"). next() and prev()
+// are O(1), and reversing any path is O(sqrt(n)): the path is split off at segment
+// boundaries, the order of its segments is reversed and their bits are flipped, instead of
+// moving every city. Short segments left by the splits are merged back. A path that wraps
+// around the end of the segment order is reversed through its complement, which leaves the
+// same cycle traversed the other way; a global flipped bit then swaps next() and prev().
+class TwoLevelList
+{
+private:
+    struct Segment
+    {
+        std::vector<int> cities;
+        bool reversed = false;
+        int rank = 0;  // position in order
+        int start = 0; // raw position of its first city
+    };
+
+    std::vector<Segment> segments; // indexed by id; ids in freeIds are unused
+    std::vector<int> freeIds;
+    std::vector<int> order; // segment ids in raw tour order
+    std::vector<int> segmentOf;
+    std::vector<int> indexOf; // index into the segment's cities vector
+    bool flipped = false;
+    int targetSize;
+
+public:
+    // tour lists every city 0..n-1 once, in visiting order.
+    explicit TwoLevelList(const std::vector<int> &tour)
+        : segmentOf(tour.size()), indexOf(tour.size()),
+          targetSize(std::max(8, static_cast<int>(std::sqrt(static_cast<double>(tour.size())))))
+    {
+        build(tour);
+    }
+
+    int size() const
+    {
+        return static_cast<int>(segmentOf.size());
+    }
+
+    int next(int city) const
+    {
+        return flipped ? rawPrev(city) : rawNext(city);
+    }
+
+    int prev(int city) const
+    {
+        return flipped ? rawNext(city) : rawPrev(city);
+    }
+
+    // Reverses the path from a to b that follows next().
+    void reverse(int a, int b)
+    {
+        if (flipped)
+        {
+            rawReverse(b, a);
+        }
+        else
+        {
+            rawReverse(a, b);
+        }
+    }
+
+    // Every city once, starting at from and following next().
+    std::vector<int> tour(int from) const
+    {
+        std::vector<int> cities;
+        cities.reserve(segmentOf.size());
+        int city = from;
+        do
+        {
+            cities.push_back(city);
+            city = next(city);
+        } while (city != from);
+        return cities;
+    }
+
+private:
+    void build(const std::vector<int> &tour)
+    {
+        segments.clear();
+        freeIds.clear();
+        order.clear();
+        for (size_t begin = 0; begin < tour.size(); begin += targetSize)
+        {
+            size_t end = std::min(tour.size(), begin + targetSize);
+            Segment segment;
+            segment.cities.assign(tour.begin() + begin, tour.begin() + end);
+            for (size_t k = 0; k < segment.cities.size(); ++k)
+            {
+                segmentOf[segment.cities[k]] = static_cast<int>(segments.size());
+                indexOf[segment.cities[k]] = static_cast<int>(k);
+            }
+            order.push_back(static_cast<int>(segments.size()));
+            segments.push_back(std::move(segment));
+        }
+        renumber(0);
+    }
+
+    int length(int id) const
+    {
+        return static_cast<int>(segments[id].cities.size());
+    }
+
+    // Offset of a city from the first city of its segment in raw order.
+    int offset(int city) const
+    {
+        const Segment &segment = segments[segmentOf[city]];
+        return segment.reversed ? length(segmentOf[city]) - 1 - indexOf[city] : indexOf[city];
+    }
+
+    int position(int city) const
+    {
+        return segments[segmentOf[city]].start + offset(city);
+    }
+
+    int at(int id, int k) const
+    {
+        const Segment &segment = segments[id];
+        return segment.cities[segment.reversed ? length(id) - 1 - k : k];
+    }
+
+    int rawNext(int city) const
+    {
+        int id = segmentOf[city];
+        int k = offset(city);
+        if (k + 1 < length(id))
+        {
+            return at(id, k + 1);
+        }
+        return at(order[(segments[id].rank + 1) % order.size()], 0);
+    }
+
+    int rawPrev(int city) const
+    {
+        int id = segmentOf[city];
+        int k = offset(city);
+        if (k > 0)
+        {
+            return at(id, k - 1);
+        }
+        int before = order[(segments[id].rank + order.size() - 1) % order.size()];
+        return at(before, length(before) - 1);
+    }
+
+    void rawReverse(int a, int b)
+    {
+        if (rawNext(b) == a)
+        {
+            flipped = !flipped; // the whole cycle
+            return;
+        }
+        if (position(a) > position(b))
+        {
+            int from = rawNext(b);
+            b = rawPrev(a);
+            a = from;
+            flipped = !flipped;
+        }
+
+        split(a);
+        split(rawNext(b));
+        int first = segments[segmentOf[a]].rank;
+        int last = segments[segmentOf[b]].rank;
+        std::reverse(order.begin() + first, order.begin() + last + 1);
+        for (int rank = first; rank <= last; ++rank)
+        {
+            segments[order[rank]].reversed = !segments[order[rank]].reversed;
+        }
+        renumber(first);
+
+        // Splits leave short segments at both ends of the path; join them with their neighbours.
+        if (last + 1 < static_cast<int>(order.size()))
+        {
+            mergeAt(last);
+        }
+        if (first > 0)
+        {
+            mergeAt(first - 1);
+        }
+        if (static_cast<int>(order.size()) > 4 * (size() / targetSize + 1))
+        {
+            std::vector<int> cities = tour(at(order[0], 0));
+            flipped = false;
+            build(cities);
+        }
+    }
+
+    // Makes city the first of its segment.
+    void split(int city)
+    {
+        int id = segmentOf[city];
+        int k = offset(city);
+        if (k == 0)
+        {
+            return;
+        }
+        normalize(id);
+        int added;
+        if (freeIds.empty())
+        {
+            added = static_cast<int>(segments.size());
+            segments.emplace_back();
+        }
+        else
+        {
+            added = freeIds.back();
+            freeIds.pop_back();
+        }
+        Segment &segment = segments[id];
+        Segment &tail = segments[added];
+        tail.reversed = false;
+        tail.cities.assign(segment.cities.begin() + k, segment.cities.end());
+        segment.cities.resize(k);
+        for (size_t i = 0; i < tail.cities.size(); ++i)
+        {
+            segmentOf[tail.cities[i]] = added;
+            indexOf[tail.cities[i]] = static_cast<int>(i);
+        }
+        int rank = segment.rank;
+        order.insert(order.begin() + rank + 1, added);
+        renumber(rank);
+    }
+
+    // Joins the segments at rank and rank + 1 if together they are no longer than the target.
+    void mergeAt(int rank)
+    {
+        int id = order[rank];
+        int following = order[rank + 1];
+        if (length(id) + length(following) > targetSize)
+        {
+            return;
+        }
+        normalize(id);
+        normalize(following);
+        Segment &segment = segments[id];
+        for (int city : segments[following].cities)
+        {
+            segmentOf[city] = id;
+            indexOf[city] = static_cast<int>(segment.cities.size());
+            segment.cities.push_back(city);
+        }
+        segments[following].cities.clear();
+        freeIds.push_back(following);
+        order.erase(order.begin() + rank + 1);
+        renumber(rank);
+    }
+
+    // Stores the segment in raw order so it can be cut or extended.
+    void normalize(int id)
+    {
+        Segment &segment = segments[id];
+        if (!segment.reversed)
+        {
+            return;
+        }
+        std::reverse(segment.cities.begin(), segment.cities.end());
+        for (size_t i = 0; i < segment.cities.size(); ++i)
+        {
+            indexOf[segment.cities[i]] = static_cast<int>(i);
+        }
+        segment.reversed = false;
+    }
+
+    void renumber(int from)
+    {
+        int start = from > 0 ? segments[order[from - 1]].start + length(order[from - 1]) : 0;
+        for (int rank = from; rank < static_cast<int>(order.size()); ++rank)
+        {
+            Segment &segment = segments[order[rank]];
+            segment.rank = rank;
+            segment.start = start;
+            start += static_cast<int>(segment.cities.size());
+        }
+    }
+};
+
+} // namespace vrp
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+namespace vrp
+{
+
+// 2-opt on a depot-to-depot trip with O(1) delta evaluation. Roads are directed, so the
+// reversed segment's own cost change is accumulated while j grows. cost(a, b) must return a
+// large value for missing roads so moves onto them are never taken.
+template <typename CostFunction>
+bool twoOpt(std::vector<int> &route, CostFunction cost)
+{
+    bool improved = false;
+    bool improvement = true;
+    while (improvement)
+    {
+        improvement = false;
+        for (size_t i = 1; i + 2 < route.size(); ++i)
+        {
+            long long reversedDelta = 0;
+            for (size_t j = i + 1; j + 1 < route.size(); ++j)
+            {
+                reversedDelta += static_cast<long long>(cost(route[j], route[j - 1])) - cost(route[j - 1], route[j]);
+                long long delta = reversedDelta + cost(route[i - 1], route[j]) + cost(route[i], route[j + 1]) -
+                                  cost(route[i - 1], route[i]) - cost(route[j], route[j + 1]);
+                if (delta < 0)
+                {
+                    std::reverse(route.begin() + i, route.begin() + j + 1);
+                    improvement = improved = true;
+                    reversedDelta = 0;
+                    for (size_t k = i + 1; k <= j; ++k)
+                    {
+                        reversedDelta += static_cast<long long>(cost(route[k], route[k - 1])) - cost(route[k - 1], route[k]);
+                    }
+                }
+            }
+        }
+    }
+    return improved;
+}
+
+} // namespace vrp
@@ -0,0 +1,854 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "fixed_size_solver.hpp"
+#include "thread_pool.hpp"
+#include "two_opt.hpp"
+
+namespace vrp
+{
+
+using Route = std::vector<int>;
+
+struct Edge
+{
+    int start;
+    int destination;
+    int cost;
+};
+
+// One kind of vehicle. A trip driven by it costs costPerUnit times its road cost.
+struct VehicleType
+{
+    static constexpr int UNLIMITED = -1;
+
+    int capacity = 0;
+    int maxStops = 0;
+    int costPerUnit = 1;
+    int count = UNLIMITED;
+};
+
+// Same data as the text inputs: packageWeights[0] is the depot, cities are 1..numberOfCustomers.
+// An empty fleet means unlimited identical vehicles of vehicleCapacity and maxCitiesPerRoute.
+struct Instance
+{
+    int numberOfCustomers = 0;
+    std::vector<int> packageWeights{0};
+    std::vector<Edge> roads;
+    int vehicleCapacity = 0;
+    int maxCitiesPerRoute = 0;
+    std::vector<VehicleType> fleet;
+    int maxVehicles = 0; // 0: no limit on the number of trips
+};
+
+struct Solution
+{
+    long long cost = LLONG_MAX;
+    bool feasible = false;
+    bool timedOut = false; // the global engine hit its time limit; routes hold the incumbent
+    std::vector<Route> routes; // one depot-to-depot trip per vehicle
+    std::vector<int> vehicleTypes; // fleet index of the vehicle driving each route
+    long long nodesExpanded = 0;
+    double loadMicros = 0;
+    double solveMicros = 0;
+};
+
+enum class Engine
+{
+    Local,
+    Global
+};
+
+// Binary graphs hold the same data as the text format: "VRPG", a uint32 version, a uint32
+// customer count, one int32 weight per customer, a uint64 road count and int32 start,
+// destination, cost triples, all in native byte order.
+constexpr char BINARY_GRAPH_MAGIC[4] = {'V', 'R', 'P', 'G'};
+constexpr uint32_t BINARY_GRAPH_VERSION = 1;
+
+// Bytes between the read position and the end of the file.
+inline uint64_t remainingBytes(std::ifstream &file)
+{
+    std::streampos position = file.tellg();
+    file.seekg(0, std::ios::end);
+    std::streampos end = file.tellg();
+    file.seekg(position);
+    return position < 0 || end < position ? 0 : static_cast<uint64_t>(end - position);
+}
+
+// The counts in the header are checked against the size of the file before anything is
+// allocated, so a truncated or corrupt file fails instead of allocating or reading past its end.
+inline void readBinaryGraph(std::ifstream &file, const std::string &filename, Instance &instance)
+{
+    uint32_t version, numCities;
+    uint64_t numRoutes;
+    file.read(reinterpret_cast<char *>(&version), sizeof(version));
+    if (!file || version != BINARY_GRAPH_VERSION)
+    {
+        throw std::runtime_error("Unsupported binary graph version in " + filename + ".");
+    }
+    file.read(reinterpret_cast<char *>(&numCities), sizeof(numCities));
+    if (!file || remainingBytes(file) < sizeof(int32_t) * static_cast<uint64_t>(numCities) + sizeof(numRoutes))
+    {
+        throw std::runtime_error("Truncated binary graph " + filename + ".");
+    }
+    instance.numberOfCustomers = numCities;
+    instance.packageWeights.assign(static_cast<size_t>(numCities) + 1, 0);
+    file.read(reinterpret_cast<char *>(instance.packageWeights.data() + 1), sizeof(int) * numCities);
+    file.read(reinterpret_cast<char *>(&numRoutes), sizeof(numRoutes));
+    if (!file || numRoutes > remainingBytes(file) / sizeof(Edge))
+    {
+        throw std::runtime_error("Truncated binary graph " + filename + ".");
+    }
+    instance.roads.resize(numRoutes);
+    static_assert(sizeof(Edge) == 3 * sizeof(int32_t), "Edge must match the binary road layout.");
+    file.read(reinterpret_cast<char *>(instance.roads.data()), sizeof(Edge) * numRoutes);
+    if (!file)
+    {
+        throw std::runtime_error("Truncated binary graph " + filename + ".");
+    }
+}
+
+inline Instance readInstance(const std::string &filename, int vehicleCapacity, int maxCitiesPerRoute)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to open input file.");
+    }
+
+    Instance instance;
+    instance.vehicleCapacity = vehicleCapacity;
+    instance.maxCitiesPerRoute = maxCitiesPerRoute;
+
+    char magic[sizeof(BINARY_GRAPH_MAGIC)] = {};
+    file.read(magic, sizeof(magic));
+    if (file && std::memcmp(magic, BINARY_GRAPH_MAGIC, sizeof(magic)) == 0)
+    {
+        readBinaryGraph(file, filename, instance);
+        return instance;
+    }
+    file.clear();
+    file.seekg(0);
+
+    // Every city line and road line takes a few bytes, which bounds the counts a file can hold.
+    uint64_t size = remainingBytes(file);
+    int numCities, numRoutes;
+    file >> numCities;
+    if (!file || numCities < 0 || static_cast<uint64_t>(numCities) > size / 4)
+    {
+        throw std::runtime_error("Malformed input file " + filename + ".");
+    }
+    instance.numberOfCustomers = numCities;
+    instance.packageWeights.assign(numCities + 1, 0);
+    for (int i = 1; i <= numCities; ++i)
+    {
+        int number;
+        file >> number >> instance.packageWeights[i];
+    }
+
+    file >> numRoutes;
+    if (!file || numRoutes < 0 || static_cast<uint64_t>(numRoutes) > size / 6)
+    {
+        throw std::runtime_error("Malformed input file " + filename + ".");
+    }
+    instance.roads.resize(numRoutes);
+    for (auto &road : instance.roads)
+    {
+        file >> road.start >> road.destination >> road.cost;
+    }
+
+    if (!file)
+    {
+        throw std::runtime_error("Malformed input file " + filename + ".");
+    }
+    return instance;
+}
+
+// Writes the graph of an instance in the text input format, or in the binary one.
+inline void writeInstance(const std::string &filename, const Instance &instance, bool binary)
+{
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to open output file " + filename + ".");
+    }
+
+    if (binary)
+    {
+        uint32_t numCities = instance.numberOfCustomers;
+        uint64_t numRoutes = instance.roads.size();
+        file.write(BINARY_GRAPH_MAGIC, sizeof(BINARY_GRAPH_MAGIC));
+        file.write(reinterpret_cast<const char *>(&BINARY_GRAPH_VERSION), sizeof(BINARY_GRAPH_VERSION));
+        file.write(reinterpret_cast<const char *>(&numCities), sizeof(numCities));
+        file.write(reinterpret_cast<const char *>(instance.packageWeights.data() + 1), sizeof(int) * numCities);
+        file.write(reinterpret_cast<const char *>(&numRoutes), sizeof(numRoutes));
+        file.write(reinterpret_cast<const char *>(instance.roads.data()), sizeof(Edge) * numRoutes);
+    }
+    else
+    {
+        // Formatted into a large buffer with to_chars; iostream formatting dominates otherwise.
+        std::string buffer;
+        buffer.reserve(1 << 22);
+        char digits[16];
+        auto put = [&](long long value, char separator)
+        {
+            char *end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+            buffer.append(digits, end);
+            buffer += separator;
+            if (buffer.size() >= (1 << 22) - 64)
+            {
+                file.write(buffer.data(), buffer.size());
+                buffer.clear();
+            }
+        };
+        put(instance.numberOfCustomers, '\n');
+        for (int city = 1; city <= instance.numberOfCustomers; ++city)
+        {
+            put(city, ' ');
+            put(instance.packageWeights[city], '\n');
+        }
+        put(instance.roads.size(), '\n');
+        for (const Edge &road : instance.roads)
+        {
+            put(road.start, ' ');
+            put(road.destination, ' ');
+            put(road.cost, '\n');
+        }
+        file.write(buffer.data(), buffer.size());
+    }
+
+    if (!file)
+    {
+        throw std::runtime_error("Failed to write " + filename + ".");
+    }
+}
+
+// One "count capacity maxStops costPerUnit" line per vehicle type; a count of -1 is unlimited.
+inline std::vector<VehicleType> readFleet(const std::string &filename)
+{
+    std::ifstream file(filename);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to open fleet file.");
+    }
+
+    std::vector<VehicleType> fleet;
+    VehicleType vehicle;
+    while (file >> vehicle.count >> vehicle.capacity >> vehicle.maxStops >> vehicle.costPerUnit)
+    {
+        fleet.push_back(vehicle);
+    }
+    if (!file.eof() || fleet.empty())
+    {
+        throw std::runtime_error("Malformed fleet file " + filename + ".");
+    }
+    return fleet;
+}
+
+class VRPSolver
+{
+public:
+    static constexpr int NO_ROAD = 1000000000;
+
+private:
+    int numberOfCities = 0; // depot included
+    int vehicleCapacity = 0;
+    int maxCitiesPerRoute = 0;
+    std::vector<int> weights;
+    std::vector<int> costMatrix;
+    std::vector<int> minIncoming;
+    std::vector<VehicleType> fleet;
+    int maxVehicles = 0;
+    int minCostPerUnit = 1;
+    std::vector<int> typesByCapacity;
+    std::vector<int> typesByStops;
+
+    // Scratch state kept between solves so a reused solver does not reallocate.
+    std::vector<char> visited;
+    Route path;
+    Route bestPath;
+    Route trip;
+    Route candidateTrip;
+    std::vector<int> remainingVehicles;
+    std::vector<int> tripTypes;
+    std::vector<int> bestTypes;
+    FixedSizeResult fixedSizeResult;
+    long long bestCost = LLONG_MAX;
+    long long nodesExpanded = 0;
+    double timeLimitMillis = 0;
+    std::chrono::steady_clock::time_point deadline;
+    bool timedOut = false;
+
+public:
+    VRPSolver() = default;
+
+    explicit VRPSolver(const Instance &instance)
+    {
+        load(instance);
+    }
+
+    void load(const Instance &instance)
+    {
+        load(instance, instance.vehicleCapacity, instance.maxCitiesPerRoute);
+        if (!instance.fleet.empty())
+        {
+            setFleet(instance.fleet, instance.maxVehicles);
+        }
+        else if (instance.maxVehicles > 0)
+        {
+            setFleet(fleet, instance.maxVehicles);
+        }
+    }
+
+    // Loads a cached graph with per-request limits.
+    void load(const Instance &instance, int capacity, int maxStops)
+    {
+        beginLoad(instance.numberOfCustomers, capacity, maxStops);
+        std::copy(instance.packageWeights.begin(), instance.packageWeights.begin() + numberOfCities, weights.begin());
+        for (const Edge &road : instance.roads)
+        {
+            setRoad(road.start, road.destination, road.cost);
+        }
+        finishLoad();
+    }
+
+    // Loads an instance straight from caller-owned arrays; packageWeights holds cities 1..numberOfCustomers.
+    void load(int numberOfCustomers, const int *packageWeights, int numberOfRoads, const int *starts,
+              const int *destinations, const int *costs, int capacity, int maxStops)
+    {
+        beginLoad(numberOfCustomers, capacity, maxStops);
+        weights[0] = 0;
+        std::copy(packageWeights, packageWeights + numberOfCustomers, weights.begin() + 1);
+        for (int i = 0; i < numberOfRoads; ++i)
+        {
+            setRoad(starts[i], destinations[i], costs[i]);
+        }
+        finishLoad();
+    }
+
+    // Replaces the single unlimited vehicle type of load(); maxTrips 0 leaves the number of trips unbounded.
+    void setFleet(const std::vector<VehicleType> &vehicles, int maxTrips = 0)
+    {
+        if (vehicles.empty())
+        {
+            throw std::runtime_error("The fleet needs at least one vehicle type.");
+        }
+        for (const VehicleType &vehicle : vehicles)
+        {
+            if (vehicle.capacity < 0 || vehicle.maxStops < 0 || vehicle.costPerUnit < 0 || vehicle.count < VehicleType::UNLIMITED)
+            {
+                throw std::runtime_error("Invalid vehicle type.");
+            }
+        }
+        fleet = vehicles;
+        maxVehicles = maxTrips;
+        minCostPerUnit = INT_MAX;
+        for (const VehicleType &vehicle : fleet)
+        {
+            minCostPerUnit = std::min(minCostPerUnit, vehicle.costPerUnit);
+        }
+        typesByCapacity.resize(fleet.size());
+        for (size_t type = 0; type < fleet.size(); ++type)
+        {
+            typesByCapacity[type] = type;
+        }
+        typesByStops = typesByCapacity;
+        std::sort(typesByCapacity.begin(), typesByCapacity.end(), [this](int a, int b)
+                  { return fleet[a].capacity > fleet[b].capacity; });
+        std::sort(typesByStops.begin(), typesByStops.end(), [this](int a, int b)
+                  { return fleet[a].maxStops > fleet[b].maxStops; });
+    }
+
+    // Bounds the global engine; 0 disables the limit.
+    void setTimeLimit(double milliseconds)
+    {
+        timeLimitMillis = milliseconds;
+    }
+
+    int cities() const
+    {
+        return numberOfCities;
+    }
+
+    int cost(int from, int to) const
+    {
+        return costMatrix[static_cast<size_t>(from) * numberOfCities + to];
+    }
+
+    Solution solve(Engine engine)
+    {
+        return engine == Engine::Global ? solveGlobal() : solveLocal();
+    }
+
+    // Nearest-neighbour trips from the depot followed by 2-opt, as in local-search. With several
+    // vehicle types every available type builds a candidate trip and the one with the lowest cost
+    // per delivered city is kept.
+    Solution solveLocal()
+    {
+        auto startTime = std::chrono::steady_clock::now();
+        Solution solution;
+        visited.assign(numberOfCities, 0);
+        visited[0] = 1;
+        int remaining = numberOfCities - 1;
+        long long totalCost = 0;
+        bool feasible = true;
+        bool singleType = isSingleType();
+        remainingVehicles.resize(fleet.size());
+        for (size_t type = 0; type < fleet.size(); ++type)
+        {
+            remainingVehicles[type] = fleet[type].count;
+        }
+
+        while (remaining > 0)
+        {
+            if (maxVehicles > 0 && static_cast<int>(solution.routes.size()) == maxVehicles)
+            {
+                break;
+            }
+            int chosenType = 0;
+            long long chosenCost = 0;
+            bool drivable = true;
+            if (singleType)
+            {
+                chosenCost = buildTrip(fleet[0], trip, remaining, drivable) * fleet[0].costPerUnit;
+            }
+            else
+            {
+                chosenType = -1;
+                double bestScore = 0;
+                for (size_t type = 0; type < fleet.size(); ++type)
+                {
+                    if (remainingVehicles[type] == 0)
+                    {
+                        continue;
+                    }
+                    bool candidateDrivable = true;
+                    long long candidateCost = buildTrip(fleet[type], candidateTrip, remaining, candidateDrivable) * fleet[type].costPerUnit;
+                    int stops = candidateTrip.size() - 2;
+                    for (int i = 1; i <= stops; ++i)
+                    {
+                        visited[candidateTrip[i]] = 0;
+                    }
+                    remaining += stops;
+                    double score = stops > 0 ? static_cast<double>(candidateCost) / stops : 0;
+                    if (stops > 0 && (chosenType == -1 || score < bestScore))
+                    {
+                        chosenType = type;
+                        bestScore = score;
+                        std::swap(trip, candidateTrip);
+                    }
+                }
+                if (chosenType == -1)
+                {
+                    break;
+                }
+                for (size_t i = 1; i + 1 < trip.size(); ++i)
+                {
+                    visited[trip[i]] = 1;
+                }
+                remaining -= trip.size() - 2;
+                if (remainingVehicles[chosenType] > 0)
+                {
+                    --remainingVehicles[chosenType];
+                }
+                chosenCost = tripCost(trip, drivable) * fleet[chosenType].costPerUnit;
+            }
+            if (trip.size() <= 2)
+            {
+                break;
+            }
+            feasible = feasible && drivable;
+            totalCost += chosenCost;
+            solution.routes.push_back(trip);
+            solution.vehicleTypes.push_back(chosenType);
+        }
+
+        solution.feasible = feasible && remaining == 0;
+        solution.cost = totalCost;
+        finish(solution, startTime);
+        return solution;
+    }
+
+    // Exact depth-first branch and bound over trips. Each new trip is forced to contain the
+    // lowest unvisited city, which removes the trip-order permutations global-search enumerates.
+    // Small single-type instances run the kernel specialized for their size.
+    Solution solveGlobal()
+    {
+        if (numberOfCities > 64)
+        {
+            throw std::runtime_error("Global search supports at most 63 cities.");
+        }
+        auto startTime = std::chrono::steady_clock::now();
+        Solution solution;
+        bestCost = LLONG_MAX;
+        path.clear();
+        path.push_back(0);
+        bestPath.clear();
+        timedOut = false;
+        deadline = startTime + std::chrono::microseconds(static_cast<long long>(timeLimitMillis * 1000));
+
+        long long lowerBound = 0;
+        for (int city = 1; city < numberOfCities; ++city)
+        {
+            lowerBound += minIncoming[city];
+        }
+        uint64_t unvisited = numberOfCities > 1 ? (~0ULL >> (65 - numberOfCities)) << 1 : 0;
+        // A single unlimited vehicle type keeps the original search; its cost rate only scales
+        // the result.
+        bool singleType = isSingleType();
+        if (lowerBound < NO_ROAD)
+        {
+            if (singleType)
+            {
+                vehicleCapacity = fleet[0].capacity;
+                maxCitiesPerRoute = fleet[0].maxStops;
+                if (hasFixedSizeKernel(numberOfCities))
+                {
+                    solveFixedSize(numberOfCities, costMatrix.data(), weights.data(), vehicleCapacity, maxCitiesPerRoute,
+                                   NO_ROAD, timeLimitMillis, fixedSizeResult);
+                    bestCost = fixedSizeResult.cost;
+                    bestPath = fixedSizeResult.path;
+                    nodesExpanded += fixedSizeResult.nodesExpanded;
+                    timedOut = fixedSizeResult.timedOut;
+                }
+                else
+                {
+                    searchGlobal(0, unvisited, 0, 0, 0, 0, lowerBound, false);
+                }
+            }
+            else
+            {
+                remainingVehicles.resize(fleet.size());
+                for (size_t type = 0; type < fleet.size(); ++type)
+                {
+                    remainingVehicles[type] = fleet[type].count;
+                }
+                tripTypes.clear();
+                bestTypes.clear();
+                searchFleet(unvisited, 0, lowerBound);
+            }
+        }
+
+        if (bestCost != LLONG_MAX)
+        {
+            solution.feasible = true;
+            solution.cost = singleType ? bestCost * fleet[0].costPerUnit : bestCost;
+            Route current{0};
+            for (size_t i = 1; i < bestPath.size(); ++i)
+            {
+                current.push_back(bestPath[i]);
+                if (bestPath[i] == 0)
+                {
+                    solution.vehicleTypes.push_back(singleType ? 0 : bestTypes[solution.routes.size()]);
+                    solution.routes.push_back(current);
+                    current.assign(1, 0);
+                }
+            }
+        }
+        finish(solution, startTime);
+        return solution;
+    }
+
+private:
+    void beginLoad(int numberOfCustomers, int capacity, int maxStops)
+    {
+        numberOfCities = numberOfCustomers + 1;
+        vehicleCapacity = capacity;
+        maxCitiesPerRoute = maxStops;
+        weights.resize(numberOfCities);
+        costMatrix.assign(static_cast<size_t>(numberOfCities) * numberOfCities, NO_ROAD);
+        setFleet({VehicleType{capacity, maxStops, 1, VehicleType::UNLIMITED}});
+    }
+
+    bool isSingleType() const
+    {
+        return fleet.size() == 1 && fleet[0].count == VehicleType::UNLIMITED && maxVehicles == 0;
+    }
+
+    // Marks the cities of the new trip as visited; drivable turns false when a leg has no road.
+    long long buildTrip(const VehicleType &vehicle, Route &out, int &remaining, bool &drivable)
+    {
+        out.clear();
+        out.push_back(0);
+        int currentCity = 0;
+        int load = 0;
+        while (static_cast<int>(out.size()) - 1 < vehicle.maxStops && remaining > 0)
+        {
+            int nextCity = -1;
+            int minCost = NO_ROAD;
+            const int *row = &costMatrix[static_cast<size_t>(currentCity) * numberOfCities];
+            for (int city = 1; city < numberOfCities; ++city)
+            {
+                if (!visited[city] && row[city] < minCost && load + weights[city] <= vehicle.capacity)
+                {
+                    nextCity = city;
+                    minCost = row[city];
+                }
+            }
+            if (nextCity == -1)
+            {
+                break;
+            }
+            out.push_back(nextCity);
+            visited[nextCity] = 1;
+            load += weights[nextCity];
+            currentCity = nextCity;
+            --remaining;
+            ++nodesExpanded;
+        }
+        out.push_back(0);
+        if (out.size() == 2)
+        {
+            return 0;
+        }
+        twoOpt(out, [this](int from, int to)
+               { return cost(from, to); });
+        return tripCost(out, drivable);
+    }
+
+    long long tripCost(const Route &route, bool &drivable) const
+    {
+        long long total = 0;
+        for (size_t i = 0; i + 1 < route.size(); ++i)
+        {
+            int arc = cost(route[i], route[i + 1]);
+            drivable = drivable && arc != NO_ROAD;
+            total += arc;
+        }
+        return total;
+    }
+
+    // Relaxation of the fleet limits: the vehicles still available, largest first, must be able
+    // to carry the remaining weight and make the remaining stops.
+    bool fleetCanCover(uint64_t unvisited) const
+    {
+        long long unvisitedWeight = 0;
+        for (uint64_t bits = unvisited; bits != 0; bits &= bits - 1)
+        {
+            unvisitedWeight += weights[__builtin_ctzll(bits)];
+        }
+        int tripsLeft = maxVehicles > 0 ? maxVehicles - static_cast<int>(tripTypes.size()) : INT_MAX;
+        return fleetTotal(typesByCapacity, tripsLeft, &VehicleType::capacity) >= unvisitedWeight &&
+               fleetTotal(typesByStops, tripsLeft, &VehicleType::maxStops) >= __builtin_popcountll(unvisited);
+    }
+
+    long long fleetTotal(const std::vector<int> &order, int tripsLeft, int VehicleType::*field) const
+    {
+        long long total = 0;
+        for (int type : order)
+        {
+            if (tripsLeft == 0)
+            {
+                break;
+            }
+            int available = remainingVehicles[type] == VehicleType::UNLIMITED ? tripsLeft : std::min(tripsLeft, remainingVehicles[type]);
+            total += static_cast<long long>(available) * (fleet[type].*field);
+            tripsLeft -= available;
+        }
+        return total;
+    }
+
+    void setRoad(int start, int destination, int roadCost)
+    {
+        if (start < 0 || start >= numberOfCities || destination < 0 || destination >= numberOfCities)
+        {
+            throw std::runtime_error("Road references an unknown city.");
+        }
+        int &slot = costMatrix[static_cast<size_t>(start) * numberOfCities + destination];
+        slot = std::min(slot, roadCost);
+    }
+
+    void finishLoad()
+    {
+        minIncoming.assign(numberOfCities, NO_ROAD);
+        for (int from = 0; from < numberOfCities; ++from)
+        {
+            for (int to = 0; to < numberOfCities; ++to)
+            {
+                if (from != to)
+                {
+                    minIncoming[to] = std::min(minIncoming[to], cost(from, to));
+                }
+            }
+        }
+        nodesExpanded = 0;
+    }
+
+    void finish(Solution &solution, std::chrono::steady_clock::time_point startTime)
+    {
+        solution.timedOut = timedOut;
+        solution.nodesExpanded = nodesExpanded;
+        nodesExpanded = 0;
+        solution.solveMicros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+    }
+
+    // lowerBound is the sum of the cheapest incoming road of every unvisited city.
+    void searchGlobal(int currentCity, uint64_t unvisited, int load, int stops, long long costSoFar,
+                      int anchor, long long lowerBound, bool anchorVisited)
+    {
+        ++nodesExpanded;
+        if ((nodesExpanded & 4095) == 0 && timeLimitMillis > 0 && std::chrono::steady_clock::now() > deadline)
+        {
+            timedOut = true;
+        }
+        if (timedOut || costSoFar + lowerBound >= bestCost)
+        {
+            return;
+        }
+
+        if (currentCity == 0)
+        {
+            if (unvisited == 0)
+            {
+                bestCost = costSoFar;
+                bestPath = path;
+                return;
+            }
+            anchor = __builtin_ctzll(unvisited);
+            anchorVisited = false;
+        }
+        else if (anchorVisited && cost(currentCity, 0) != NO_ROAD)
+        {
+            path.push_back(0);
+            searchGlobal(0, unvisited, 0, 0, costSoFar + cost(currentCity, 0), anchor, lowerBound, false);
+            path.pop_back();
+        }
+
+        if (stops == maxCitiesPerRoute)
+        {
+            return;
+        }
+        for (uint64_t candidates = unvisited; candidates != 0; candidates &= candidates - 1)
+        {
+            int city = __builtin_ctzll(candidates);
+            int arc = cost(currentCity, city);
+            if (arc == NO_ROAD || load + weights[city] > vehicleCapacity)
+            {
+                continue;
+            }
+            path.push_back(city);
+            searchGlobal(city, unvisited & ~(1ULL << city), load + weights[city], stops + 1, costSoFar + arc,
+                         anchor, lowerBound - minIncoming[city], anchorVisited || city == anchor);
+            path.pop_back();
+        }
+    }
+
+    // Heterogeneous variant of searchGlobal(): every trip starts by choosing an available vehicle
+    // type, costs are scaled by its rate, and trip starts are pruned by fleetCanCover().
+    void searchFleet(uint64_t unvisited, long long costSoFar, long long lowerBound)
+    {
+        if (unvisited == 0)
+        {
+            if (costSoFar < bestCost)
+            {
+                bestCost = costSoFar;
+                bestPath = path;
+                bestTypes = tripTypes;
+            }
+            return;
+        }
+        if (costSoFar + lowerBound * minCostPerUnit >= bestCost || !fleetCanCover(unvisited))
+        {
+            return;
+        }
+        int anchor = __builtin_ctzll(unvisited);
+        for (size_t type = 0; type < fleet.size() && !timedOut; ++type)
+        {
+            if (remainingVehicles[type] == 0)
+            {
+                continue;
+            }
+            bool limited = remainingVehicles[type] != VehicleType::UNLIMITED;
+            remainingVehicles[type] -= limited;
+            tripTypes.push_back(type);
+            extendFleetTrip(0, unvisited, 0, 0, costSoFar, anchor, lowerBound, false, fleet[type]);
+            tripTypes.pop_back();
+            remainingVehicles[type] += limited;
+        }
+    }
+
+    void extendFleetTrip(int currentCity, uint64_t unvisited, int load, int stops, long long costSoFar,
+                         int anchor, long long lowerBound, bool anchorVisited, const VehicleType &vehicle)
+    {
+        ++nodesExpanded;
+        if ((nodesExpanded & 4095) == 0 && timeLimitMillis > 0 && std::chrono::steady_clock::now() > deadline)
+        {
+            timedOut = true;
+        }
+        if (timedOut || costSoFar + lowerBound * minCostPerUnit >= bestCost)
+        {
+            return;
+        }
+
+        if (anchorVisited && cost(currentCity, 0) != NO_ROAD)
+        {
+            path.push_back(0);
+            searchFleet(unvisited, costSoFar + static_cast<long long>(cost(currentCity, 0)) * vehicle.costPerUnit, lowerBound);
+            path.pop_back();
+        }
+
+        if (stops == vehicle.maxStops)
+        {
+            return;
+        }
+        for (uint64_t candidates = unvisited; candidates != 0; candidates &= candidates - 1)
+        {
+            int city = __builtin_ctzll(candidates);
+            int arc = cost(currentCity, city);
+            if (arc == NO_ROAD || load + weights[city] > vehicle.capacity)
+            {
+                continue;
+            }
+            path.push_back(city);
+            extendFleetTrip(city, unvisited & ~(1ULL << city), load + weights[city], stops + 1,
+                            costSoFar + static_cast<long long>(arc) * vehicle.costPerUnit, anchor,
+                            lowerBound - minIncoming[city], anchorVisited || city == anchor, vehicle);
+            path.pop_back();
+        }
+    }
+};
+
+// Solves many independent instances on a shared pool; every pool slot owns one reusable VRPSolver.
+class BatchSolver
+{
+private:
+    ThreadPool pool;
+    std::vector<VRPSolver> solvers;
+
+public:
+    explicit BatchSolver(unsigned numberOfThreads = std::thread::hardware_concurrency())
+        : pool(numberOfThreads), solvers(pool.size())
+    {
+    }
+
+    unsigned threads() const
+    {
+        return pool.size();
+    }
+
+    std::vector<Solution> solve(const std::vector<Instance> &instances, Engine engine)
+    {
+        std::vector<Solution> results(instances.size());
+        pool.parallelFor(instances.size(), [&](size_t i, unsigned slot)
+                         {
+            auto loadStart = std::chrono::steady_clock::now();
+            VRPSolver &solver = solvers[slot];
+            solver.load(instances[i]);
+            double loadMicros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - loadStart).count();
+            results[i] = solver.solve(engine);
+            results[i].loadMicros = loadMicros; });
+        return results;
+    }
+};
+
+} // namespace vrp
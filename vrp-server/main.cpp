@@ -0,0 +1,471 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <exception>
+#include <csignal>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "../vrp-lib/json.hpp"
+#include "../vrp-lib/vrp_solver.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+class GraphCache
+{
+private:
+    std::mutex mutex;
+    std::map<std::string, std::shared_ptr<const vrp::Instance>> graphs;
+
+public:
+    std::shared_ptr<const vrp::Instance> get(const std::string &filename)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = graphs.find(filename);
+        if (it == graphs.end())
+        {
+            auto instance = std::make_shared<const vrp::Instance>(vrp::readInstance(filename, 0, 0));
+            it = graphs.emplace(filename, instance).first;
+        }
+        return it->second;
+    }
+};
+
+class LatencyStats
+{
+private:
+    std::mutex mutex;
+    std::vector<double> latencies;
+
+public:
+    void record(double micros)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        latencies.push_back(micros);
+    }
+
+    std::string toJson()
+    {
+        std::vector<double> sorted;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            sorted = latencies;
+        }
+        std::sort(sorted.begin(), sorted.end());
+        auto percentile = [&sorted](double p)
+        {
+            if (sorted.empty())
+            {
+                return 0.0;
+            }
+            size_t index = std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()));
+            return sorted[index];
+        };
+        std::ostringstream out;
+        out << "{\"requests\":" << sorted.size() << ",\"p50Us\":" << percentile(0.50) << ",\"p90Us\":" << percentile(0.90)
+            << ",\"p99Us\":" << percentile(0.99) << ",\"maxUs\":" << (sorted.empty() ? 0.0 : sorted.back()) << "}";
+        return out.str();
+    }
+};
+
+// One client stream. Responses are written as soon as their solve finishes, so they can
+// arrive out of order; clients match them by "id".
+class Connection
+{
+private:
+    int inputFd;
+    int outputFd;
+    std::mutex writeMutex;
+    std::mutex pendingMutex;
+    std::condition_variable pendingDone;
+    int pending = 0;
+
+public:
+    Connection(int inputFd, int outputFd) : inputFd(inputFd), outputFd(outputFd) {}
+
+    ~Connection()
+    {
+        if (inputFd > 2)
+        {
+            close(inputFd);
+        }
+    }
+
+    bool readLine(std::string &buffer, std::string &line)
+    {
+        while (true)
+        {
+            size_t newline = buffer.find('\n');
+            if (newline != std::string::npos)
+            {
+                line = buffer.substr(0, newline);
+                buffer.erase(0, newline + 1);
+                return true;
+            }
+            char chunk[4096];
+            ssize_t count = read(inputFd, chunk, sizeof(chunk));
+            if (count <= 0)
+            {
+                line.swap(buffer);
+                buffer.clear();
+                return !line.empty();
+            }
+            buffer.append(chunk, count);
+        }
+    }
+
+    void write(const std::string &response)
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        std::string message = response + "\n";
+        size_t written = 0;
+        while (written < message.size())
+        {
+            ssize_t count = ::write(outputFd, message.data() + written, message.size() - written);
+            if (count <= 0)
+            {
+                return;
+            }
+            written += count;
+        }
+    }
+
+    void begin()
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        ++pending;
+    }
+
+    void end()
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        if (--pending == 0)
+        {
+            pendingDone.notify_all();
+        }
+    }
+
+    void waitForPending()
+    {
+        std::unique_lock<std::mutex> lock(pendingMutex);
+        pendingDone.wait(lock, [this]
+                         { return pending == 0; });
+    }
+};
+
+class Server
+{
+private:
+    vrp::ThreadPool pool;
+    GraphCache graphs;
+    LatencyStats stats;
+
+public:
+    explicit Server(unsigned threads) : pool(threads) {}
+
+    std::string statsJson()
+    {
+        return stats.toJson();
+    }
+
+    void serve(const std::shared_ptr<Connection> &connection)
+    {
+        std::string buffer, line;
+        while (connection->readLine(buffer, line))
+        {
+            if (line.find_first_not_of(" \t\r") == std::string::npos)
+            {
+                continue;
+            }
+            auto received = Clock::now();
+            std::string id = "null";
+            try
+            {
+                vrp::JsonValue request = vrp::JsonValue::parse(line);
+                if (request.has("id"))
+                {
+                    id = idText(request["id"]);
+                }
+                std::string command = request.getString("cmd", "solve");
+                if (command == "stats")
+                {
+                    connection->write("{\"stats\":" + stats.toJson() + "}");
+                    continue;
+                }
+                if (command != "solve")
+                {
+                    throw std::runtime_error("Unknown command " + command + ".");
+                }
+                submit(connection, request, id, received);
+            }
+            catch (const std::exception &e)
+            {
+                connection->write("{\"id\":" + id + ",\"error\":\"" + vrp::jsonEscape(e.what()) + "\"}");
+            }
+        }
+        connection->waitForPending();
+    }
+
+private:
+    std::shared_ptr<const vrp::Instance> instanceFor(const vrp::JsonValue &request)
+    {
+        if (request.has("graph"))
+        {
+            return graphs.get(request["graph"].asString());
+        }
+
+        auto instance = std::make_shared<vrp::Instance>();
+        const auto &weights = request["cities"].items;
+        instance->numberOfCustomers = weights.size();
+        instance->packageWeights.assign(weights.size() + 1, 0);
+        for (size_t i = 0; i < weights.size(); ++i)
+        {
+            instance->packageWeights[i + 1] = weights[i].asInt();
+        }
+        for (const auto &road : request["roads"].items)
+        {
+            if (road.items.size() != 3)
+            {
+                throw std::runtime_error("Roads must be [start, destination, cost].");
+            }
+            instance->roads.push_back({road.items[0].asInt(), road.items[1].asInt(), road.items[2].asInt()});
+        }
+        return instance;
+    }
+
+    void submit(const std::shared_ptr<Connection> &connection, const vrp::JsonValue &request, const std::string &id, Clock::time_point received)
+    {
+        std::shared_ptr<const vrp::Instance> instance = instanceFor(request);
+        int capacity = request["capacity"].asInt();
+        int maxStops = request["maxStops"].asInt();
+        int timeLimit = request.getInt("timeLimitMs", 0);
+        std::string engineName = request.getString("engine", "local");
+        if (engineName != "local" && engineName != "global")
+        {
+            throw std::runtime_error("Unknown engine " + engineName + ".");
+        }
+        vrp::Engine engine = engineName == "global" ? vrp::Engine::Global : vrp::Engine::Local;
+
+        connection->begin();
+        pool.submit([this, connection, id, instance, capacity, maxStops, timeLimit, engine, received]
+                    {
+            // Each worker keeps one warm solver for its whole lifetime.
+            thread_local vrp::VRPSolver solver;
+            std::string response;
+            try
+            {
+                solver.load(*instance, capacity, maxStops);
+                solver.setTimeLimit(timeLimit);
+                vrp::Solution solution = solver.solve(engine);
+                double latency = std::chrono::duration<double, std::micro>(Clock::now() - received).count();
+                stats.record(latency);
+                response = toJson(id, solution, latency);
+            }
+            catch (const std::exception &e)
+            {
+                response = "{\"id\":" + id + ",\"error\":\"" + vrp::jsonEscape(e.what()) + "\"}";
+            }
+            connection->write(response);
+            connection->end(); });
+    }
+
+    static std::string idText(const vrp::JsonValue &id)
+    {
+        if (id.type == vrp::JsonValue::Type::String)
+        {
+            return "\"" + vrp::jsonEscape(id.text) + "\"";
+        }
+        std::ostringstream out;
+        out << id.number;
+        return out.str();
+    }
+
+    static std::string toJson(const std::string &id, const vrp::Solution &solution, double latency)
+    {
+        std::ostringstream out;
+        out << "{\"id\":" << id << ",\"feasible\":" << (solution.feasible ? "true" : "false")
+            << ",\"cost\":" << (solution.feasible ? solution.cost : -1)
+            << ",\"timedOut\":" << (solution.timedOut ? "true" : "false") << ",\"routes\":[";
+        for (size_t i = 0; i < solution.routes.size(); ++i)
+        {
+            out << (i ? ",[" : "[");
+            for (size_t j = 0; j < solution.routes[i].size(); ++j)
+            {
+                out << (j ? "," : "") << solution.routes[i][j];
+            }
+            out << "]";
+        }
+        out << "],\"solveUs\":" << solution.solveMicros << ",\"latencyUs\":" << latency << "}";
+        return out.str();
+    }
+};
+
+// Socket clients, one thread each. Every thread is joined before the server it uses goes away:
+// stop() ends the reads of the clients still connected, lets them finish the requests they
+// already sent and joins them. Threads of clients that left are joined as new ones arrive.
+class ClientThreads
+{
+private:
+    Server &server;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::map<int, std::thread> running; // by client socket, open while its entry is here
+    std::vector<std::thread> finished;
+
+public:
+    explicit ClientThreads(Server &server) : server(server) {}
+
+    ~ClientThreads()
+    {
+        stop();
+    }
+
+    void start(int clientFd)
+    {
+        joinFinished();
+        std::lock_guard<std::mutex> lock(mutex);
+        running[clientFd] = std::thread([this, clientFd]
+                                        { serveClient(clientFd); });
+    }
+
+    void stop()
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            for (const auto &[clientFd, thread] : running)
+            {
+                shutdown(clientFd, SHUT_RD);
+            }
+            changed.wait(lock, [this]
+                         { return running.empty(); });
+        }
+        joinFinished();
+    }
+
+private:
+    void serveClient(int clientFd)
+    {
+        auto connection = std::make_shared<Connection>(clientFd, clientFd);
+        server.serve(connection);
+        // The entry goes before the connection closes the socket, so stop() never shuts down
+        // a descriptor number that was already reused.
+        std::lock_guard<std::mutex> lock(mutex);
+        finished.push_back(std::move(running[clientFd]));
+        running.erase(clientFd);
+        changed.notify_all();
+    }
+
+    void joinFinished()
+    {
+        std::vector<std::thread> done;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.swap(finished);
+        }
+        for (std::thread &thread : done)
+        {
+            thread.join();
+        }
+    }
+};
+
+int listenOn(const std::string &path)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Failed to create socket.");
+    }
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+    {
+        throw std::runtime_error("Socket path is too long.");
+    }
+    std::copy(path.begin(), path.end(), address.sun_path);
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 || listen(fd, 64) < 0)
+    {
+        throw std::runtime_error("Failed to listen on " + path + ".");
+    }
+    return fd;
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        std::string socketPath;
+        unsigned threads = std::thread::hardware_concurrency();
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg == "--socket" && i + 1 < argc)
+            {
+                socketPath = argv[++i];
+            }
+            else if (arg == "--threads" && i + 1 < argc)
+            {
+                threads = std::stoi(argv[++i]);
+            }
+            else
+            {
+                std::cerr << "Usage: " << argv[0] << " [--socket <path>] [--threads <n>]" << std::endl;
+                return 1;
+            }
+        }
+
+        std::signal(SIGPIPE, SIG_IGN);
+        Server server(threads);
+
+        if (socketPath.empty())
+        {
+            server.serve(std::make_shared<Connection>(STDIN_FILENO, STDOUT_FILENO));
+        }
+        else
+        {
+            // SIGINT and SIGTERM interrupt accept() rather than restarting it, so the server stops
+            // taking clients and prints its statistics like the stdin mode does.
+            struct sigaction stop{};
+            stop.sa_handler = [](int)
+            { stopRequested = 1; };
+            sigaction(SIGINT, &stop, nullptr);
+            sigaction(SIGTERM, &stop, nullptr);
+
+            int listenFd = listenOn(socketPath);
+            std::cerr << "Listening on " << socketPath << std::endl;
+            ClientThreads clients(server);
+            while (!stopRequested)
+            {
+                int clientFd = accept(listenFd, nullptr, nullptr);
+                if (clientFd < 0)
+                {
+                    continue;
+                }
+                clients.start(clientFd);
+            }
+            close(listenFd);
+            unlink(socketPath.c_str());
+            clients.stop();
+        }
+
+        std::cerr << "Latency: " << server.statsJson() << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}